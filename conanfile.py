@@ -34,6 +34,7 @@ class InfluxdbCppRestConan(ConanFile):
     def requirements(self):
         self.requires("cpprestsdk/2.10.19")
         self.requires("rxcpp/4.1.1")
+        self.requires("zlib/[>=1.2.11 <2]")
     
     def build_requirements(self):
         # Only for tests - not linked to the library
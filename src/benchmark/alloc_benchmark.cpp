@@ -0,0 +1,99 @@
+#include <benchmark/benchmark.h>
+#include <influxdb_line.h>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+// Counts heap allocations made by the benchmarked code. The benchmarks
+// below are single-threaded, so a plain counter suffices.
+static std::size_t allocations = 0;
+
+void* operator new(std::size_t size) {
+    ++allocations;
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+// Keys and values long enough to defeat the small string optimization,
+// so that every string the path creates shows up in the count.
+static influxdb::api::line make_point(int i) {
+    return influxdb::api::line(
+        "cpu_measurement_name",
+        influxdb::api::key_value_pairs("hostname", "server-01.example.com").add("datacenter", "us-west-2a"),
+        influxdb::api::key_value_pairs("usage_percent", 0.5 + i).add("running_processes", i));
+}
+
+static void report(benchmark::State& state, std::size_t points) {
+    state.counters["allocs_per_point"] = benchmark::Counter(
+        static_cast<double>(allocations) / static_cast<double>(state.iterations() * points));
+}
+
+// One point from construction to the string handed to the HTTP body,
+// copied out with get() as insert(line const&) does.
+static void BM_AllocPointCopy(benchmark::State& state) {
+    allocations = 0;
+    for (auto _ : state) {
+        auto point = make_point(1);
+        std::string body = point.get();
+        benchmark::DoNotOptimize(body.data());
+    }
+    report(state, 1);
+}
+BENCHMARK(BM_AllocPointCopy);
+
+// As BM_AllocPointCopy, moved out with take() as insert(line&&) does.
+static void BM_AllocPointTake(benchmark::State& state) {
+    allocations = 0;
+    for (auto _ : state) {
+        std::string body = make_point(1).take();
+        benchmark::DoNotOptimize(body.data());
+    }
+    report(state, 1);
+}
+BENCHMARK(BM_AllocPointTake);
+
+// 100 points chained with operator(), formatted in place.
+static void BM_AllocChainedLines(benchmark::State& state) {
+    allocations = 0;
+    for (auto _ : state) {
+        auto lines = make_point(0);
+        for (int i = 1; i < 100; ++i) {
+            lines("cpu_measurement_name",
+                  influxdb::api::key_value_pairs("hostname", "server-01.example.com").add("datacenter", "us-west-2a"),
+                  influxdb::api::key_value_pairs("usage_percent", 0.5 + i).add("running_processes", i));
+        }
+        std::string body = lines.take();
+        benchmark::DoNotOptimize(body.data());
+    }
+    report(state, 100);
+}
+BENCHMARK(BM_AllocChainedLines);
+
+// Baseline for BM_AllocChainedLines: the previous chaining, which built
+// a temporary line per point and appended a copy of its get().
+static void BM_AllocChainedLinesCopy(benchmark::State& state) {
+    allocations = 0;
+    for (auto _ : state) {
+        std::string lines = make_point(0).get();
+        for (int i = 1; i < 100; ++i) {
+            lines.push_back('\n');
+            lines += make_point(i).get();
+        }
+        std::string body = lines;
+        benchmark::DoNotOptimize(body.data());
+    }
+    report(state, 100);
+}
+BENCHMARK(BM_AllocChainedLinesCopy);
+
+BENCHMARK_MAIN();
@@ -17,6 +17,7 @@
 #include <iomanip>
 #include <atomic>
 #include <set>
+#include <tuple>
 
 using namespace influxdb::api;
 using namespace influxdb::async_api;
@@ -31,13 +32,18 @@ const std::string DB_NAME = std::getenv("INFLUXDB_DB") ? std::getenv("INFLUXDB_D
 struct BenchmarkResult {
     unsigned batch_size;
     unsigned batch_time_ms;
+    unsigned max_in_flight;
+    bool gzip;
+    bool sorted;
     double submit_rate_req_s;      // API calls per second (lines/s)
     double http_request_rate_req_s; // HTTP requests per second
     double http_bytes_rate_bytes_s; // Bytes per second
+    double http_wire_rate_bytes_s;  // Body bytes on the wire per second (compressed if gzip)
     double actual_throughput_req_s;  // Verified inserts per second (lines/s)
     unsigned long long http_successes;
     unsigned long long http_failures;
     unsigned long long http_bytes_sent;
+    unsigned long long http_bytes_on_wire;
     unsigned long long http_bytes_received;
     unsigned long long actual_count;  // Number of lines actually inserted
     unsigned long long submitted;      // Number of lines submitted
@@ -172,6 +178,9 @@ static void BM_AsyncBatchStrategy(benchmark::State& state) {
     // Get batch parameters from state
     unsigned batch_size = static_cast<unsigned>(state.range(0));
     unsigned batch_time_ms = static_cast<unsigned>(state.range(1));
+    unsigned max_in_flight = static_cast<unsigned>(state.range(2));
+    bool gzip = state.range(3) != 0;
+    bool sorted = state.range(4) != 0;
     
     if (!setup_done) {
         setup_done = true;
@@ -188,7 +197,7 @@ static void BM_AsyncBatchStrategy(benchmark::State& state) {
     
     // Create unique database name for this benchmark run
     // Each benchmark uses its own database to avoid interference between tests
-    std::string db_name = DB_NAME + "_batch_" + std::to_string(batch_size) + "_" + std::to_string(batch_time_ms);
+    std::string db_name = DB_NAME + "_batch_" + std::to_string(batch_size) + "_" + std::to_string(batch_time_ms) + "_" + std::to_string(max_in_flight) + (gzip ? "_gzip" : "") + (sorted ? "_sorted" : "");
     
     // Setup database
     {
@@ -209,13 +218,19 @@ static void BM_AsyncBatchStrategy(benchmark::State& state) {
     }
     
     // Create async db with custom batching parameters
-    auto async_db = influxdb::async_api::simple_db(DB_URL, db_name, batch_size, batch_time_ms);
+    influxdb::api::http_config http_cfg;
+    http_cfg.max_in_flight = max_in_flight;
+    http_cfg.compression.enabled = gzip;
+    influxdb::api::batch_config batch_cfg{batch_size, batch_time_ms};
+    batch_cfg.sort_by_series = sorted;
+    auto async_db = influxdb::async_api::simple_db(DB_URL, db_name, influxdb::api::db_config{batch_cfg, http_cfg});
     auto raw_db = influxdb::raw::db_utf8(DB_URL, db_name);
     
     // Subscribe to HTTP events to track successes and failures
     std::atomic<unsigned long long> http_successes{0};
     std::atomic<unsigned long long> http_failures{0};
     std::atomic<unsigned long long> http_total_bytes_sent{0};
+    std::atomic<unsigned long long> http_total_bytes_on_wire{0};
     std::atomic<unsigned long long> http_total_bytes_received{0};
     std::atomic<unsigned long long> http_total_duration_ms{0};
     
@@ -224,6 +239,7 @@ static void BM_AsyncBatchStrategy(benchmark::State& state) {
             if (result.success) {
                 http_successes.fetch_add(1, std::memory_order_relaxed);
                 http_total_bytes_sent.fetch_add(result.bytes_sent, std::memory_order_relaxed);
+                http_total_bytes_on_wire.fetch_add(result.bytes_on_wire, std::memory_order_relaxed);
                 http_total_bytes_received.fetch_add(result.bytes_received, std::memory_order_relaxed);
                 http_total_duration_ms.fetch_add(result.duration_ms.count(), std::memory_order_relaxed);
             } else {
@@ -246,6 +262,7 @@ static void BM_AsyncBatchStrategy(benchmark::State& state) {
         http_successes.store(0);
         http_failures.store(0);
         http_total_bytes_sent.store(0);
+        http_total_bytes_on_wire.store(0);
         http_total_bytes_received.store(0);
         http_total_duration_ms.store(0);
         // Clear previous data
@@ -311,12 +328,14 @@ static void BM_AsyncBatchStrategy(benchmark::State& state) {
         unsigned long long failures = http_failures.load();
         unsigned long long total_requests = successes + failures;
         unsigned long long bytes_sent = http_total_bytes_sent.load();
+        unsigned long long bytes_on_wire = http_total_bytes_on_wire.load();
         unsigned long long bytes_received = http_total_bytes_received.load();
         
         double submit_rate_req_s = submit_duration.count() > 0 ? (lines_inserted * 1000.0) / submit_duration.count() : 0.0;
         double actual_throughput_req_s = total_duration.count() > 0 ? (actual_count * 1000.0) / total_duration.count() : 0.0;
         double http_request_rate_req_s = total_duration.count() > 0 && total_requests > 0 ? (total_requests * 1000.0) / total_duration.count() : 0.0;
         double http_bytes_rate_bytes_s = total_duration.count() > 0 && bytes_sent > 0 ? (bytes_sent * 1000.0) / total_duration.count() : 0.0;
+        double http_wire_rate_bytes_s = total_duration.count() > 0 && bytes_on_wire > 0 ? (bytes_on_wire * 1000.0) / total_duration.count() : 0.0;
         
         // Report metrics (using InfluxDB terminology: "lines" instead of "items")
         state.counters["submitted_lines"] = benchmark::Counter(lines_inserted);
@@ -324,20 +343,22 @@ static void BM_AsyncBatchStrategy(benchmark::State& state) {
         state.counters["http_successes"] = benchmark::Counter(static_cast<double>(successes));
         state.counters["http_failures"] = benchmark::Counter(static_cast<double>(failures));
         state.counters["http_bytes_sent"] = benchmark::Counter(static_cast<double>(bytes_sent));
+        state.counters["http_bytes_on_wire"] = benchmark::Counter(static_cast<double>(bytes_on_wire));
         state.counters["submit_time_ms"] = benchmark::Counter(static_cast<double>(submit_duration.count()));
         state.counters["total_time_ms"] = benchmark::Counter(static_cast<double>(total_duration.count()));
         state.counters["submit_rate_lines_per_s"] = benchmark::Counter(submit_rate_req_s, benchmark::Counter::kIsRate);
         state.counters["insert_rate_lines_per_s"] = benchmark::Counter(actual_throughput_req_s, benchmark::Counter::kIsRate);
         state.counters["http_request_rate_req_s"] = benchmark::Counter(http_request_rate_req_s, benchmark::Counter::kIsRate);
         state.counters["http_bytes_rate_bytes_s"] = benchmark::Counter(http_bytes_rate_bytes_s, benchmark::Counter::kIsRate);
+        state.counters["http_wire_rate_bytes_s"] = benchmark::Counter(http_wire_rate_bytes_s, benchmark::Counter::kIsRate);
         
         // Note: We don't use SetItemsProcessed() to avoid Google Benchmark's "items_per_second" terminology
         // Instead, we use custom counters with "lines_per_s" to use InfluxDB terminology
         
         // Store results for summary table (only once per benchmark configuration)
         // Google Benchmark runs multiple iterations, we only want to store once per benchmark configuration
-        static thread_local std::set<std::pair<unsigned, unsigned>> stored_configs;
-        auto config_key = std::make_pair(batch_size, batch_time_ms);
+        static thread_local std::set<std::tuple<unsigned, unsigned, unsigned, bool, bool>> stored_configs;
+        auto config_key = std::make_tuple(batch_size, batch_time_ms, max_in_flight, gzip, sorted);
         
         // Store on first iteration of each configuration
         if (state.iterations() == 1 && stored_configs.find(config_key) == stored_configs.end()) {
@@ -346,13 +367,18 @@ static void BM_AsyncBatchStrategy(benchmark::State& state) {
             BenchmarkResult result;
             result.batch_size = batch_size;
             result.batch_time_ms = batch_time_ms;
+            result.max_in_flight = max_in_flight;
+            result.gzip = gzip;
+            result.sorted = sorted;
             result.submit_rate_req_s = submit_rate_req_s;
             result.actual_throughput_req_s = actual_throughput_req_s;
             result.http_request_rate_req_s = http_request_rate_req_s;
             result.http_bytes_rate_bytes_s = http_bytes_rate_bytes_s;
+            result.http_wire_rate_bytes_s = http_wire_rate_bytes_s;
             result.http_successes = successes;
             result.http_failures = failures;
             result.http_bytes_sent = bytes_sent;
+            result.http_bytes_on_wire = bytes_on_wire;
             result.http_bytes_received = bytes_received;
             result.actual_count = actual_count;
             result.submitted = lines_inserted;
@@ -378,30 +404,43 @@ static void BM_AsyncBatchStrategy(benchmark::State& state) {
 }
 
 // Register benchmarks with different batching strategies
-// Format: BM_AsyncBatchStrategy(batch_size, batch_time_ms)
+// Format: BM_AsyncBatchStrategy(batch_size, batch_time_ms, max_in_flight, gzip, sorted)
 // Note: batch_size must be <= MAX_LINES (10000) to be meaningful in this benchmark
 //       If batch_size > MAX_LINES, batching will be purely time-based
 // Based on InfluxDB hardware sizing guide: https://docs.influxdata.com/influxdb/v1/guides/hardware_sizing/
 // Targeting realistic throughputs for different hardware tiers
 
 // Small batch strategies (targeting < 5,000 writes/sec on modest hardware)
-BENCHMARK(BM_AsyncBatchStrategy)->Args({100, 1000})->ArgNames({"lines", "ms"});       // Batch every 100 lines OR 1 second
-BENCHMARK(BM_AsyncBatchStrategy)->Args({500, 1000})->ArgNames({"lines", "ms"});       // Batch every 500 lines OR 1 second
-BENCHMARK(BM_AsyncBatchStrategy)->Args({1000, 1000})->ArgNames({"lines", "ms"});     // Batch every 1000 lines OR 1 second
+BENCHMARK(BM_AsyncBatchStrategy)->Args({100, 1000, 1, 0, 0})->ArgNames({"lines", "ms", "in_flight", "gzip", "sorted"});       // Batch every 100 lines OR 1 second
+BENCHMARK(BM_AsyncBatchStrategy)->Args({500, 1000, 1, 0, 0})->ArgNames({"lines", "ms", "in_flight", "gzip", "sorted"});       // Batch every 500 lines OR 1 second
+BENCHMARK(BM_AsyncBatchStrategy)->Args({1000, 1000, 1, 0, 0})->ArgNames({"lines", "ms", "in_flight", "gzip", "sorted"});     // Batch every 1000 lines OR 1 second
 
 // Medium batch strategies (targeting < 250,000 writes/sec on moderate hardware)
-BENCHMARK(BM_AsyncBatchStrategy)->Args({1000, 100})->ArgNames({"lines", "ms"});       // Batch every 1000 lines OR 100ms
-BENCHMARK(BM_AsyncBatchStrategy)->Args({5000, 100})->ArgNames({"lines", "ms"});       // Batch every 5000 lines OR 100ms
-BENCHMARK(BM_AsyncBatchStrategy)->Args({10000, 100})->ArgNames({"lines", "ms"});       // Batch every 10000 lines OR 100ms (max batch size)
+BENCHMARK(BM_AsyncBatchStrategy)->Args({1000, 100, 1, 0, 0})->ArgNames({"lines", "ms", "in_flight", "gzip", "sorted"});       // Batch every 1000 lines OR 100ms
+BENCHMARK(BM_AsyncBatchStrategy)->Args({5000, 100, 1, 0, 0})->ArgNames({"lines", "ms", "in_flight", "gzip", "sorted"});       // Batch every 5000 lines OR 100ms
+BENCHMARK(BM_AsyncBatchStrategy)->Args({10000, 100, 1, 0, 0})->ArgNames({"lines", "ms", "in_flight", "gzip", "sorted"});       // Batch every 10000 lines OR 100ms (max batch size)
 
 // Large batch strategies (targeting > 250,000 writes/sec on high-end hardware)
 // Note: These use MAX_LINES as batch_size since we're limited to 10k lines per test
-BENCHMARK(BM_AsyncBatchStrategy)->Args({10000, 50})->ArgNames({"lines", "ms"});       // Batch every 10000 lines OR 50ms
+BENCHMARK(BM_AsyncBatchStrategy)->Args({10000, 50, 1, 0, 0})->ArgNames({"lines", "ms", "in_flight", "gzip", "sorted"});       // Batch every 10000 lines OR 50ms
 
 // Time-based only strategies (for low-rate, time-critical scenarios)
 // Using MAX_LINES as batch_size since we'll never reach it - purely time-based batching
-BENCHMARK(BM_AsyncBatchStrategy)->Args({10000, 100})->ArgNames({"lines", "ms"});      // Batch every 100ms (time-based, batch_size=MAX_LINES)
-BENCHMARK(BM_AsyncBatchStrategy)->Args({10000, 1000})->ArgNames({"lines", "ms"});     // Batch every 1 second (time-based, batch_size=MAX_LINES)
+BENCHMARK(BM_AsyncBatchStrategy)->Args({10000, 100, 1, 0, 0})->ArgNames({"lines", "ms", "in_flight", "gzip", "sorted"});      // Batch every 100ms (time-based, batch_size=MAX_LINES)
+BENCHMARK(BM_AsyncBatchStrategy)->Args({10000, 1000, 1, 0, 0})->ArgNames({"lines", "ms", "in_flight", "gzip", "sorted"});     // Batch every 1 second (time-based, batch_size=MAX_LINES)
+
+// Overlapping requests (http_config::max_in_flight): several batches on the wire at once
+BENCHMARK(BM_AsyncBatchStrategy)->Args({1000, 100, 4, 0, 0})->ArgNames({"lines", "ms", "in_flight", "gzip", "sorted"});    // 1000 lines OR 100ms, up to 4 requests in flight
+BENCHMARK(BM_AsyncBatchStrategy)->Args({100, 1000, 4, 0, 0})->ArgNames({"lines", "ms", "in_flight", "gzip", "sorted"});    // 100 lines OR 1 second, up to 4 requests in flight
+
+// Compressed bodies (http_config::compression): compare HTTP (MB/s) with Wire (MB/s)
+BENCHMARK(BM_AsyncBatchStrategy)->Args({1000, 100, 1, 1, 0})->ArgNames({"lines", "ms", "in_flight", "gzip", "sorted"});    // as {1000, 100, 1, 0}, gzipped
+BENCHMARK(BM_AsyncBatchStrategy)->Args({5000, 100, 1, 1, 0})->ArgNames({"lines", "ms", "in_flight", "gzip", "sorted"});    // as {5000, 100, 1, 0}, gzipped
+
+// Series-sorted batches (batch_config::sort_by_series): compare Insert (lines/s) with the unsorted rows above
+BENCHMARK(BM_AsyncBatchStrategy)->Args({1000, 100, 1, 0, 1})->ArgNames({"lines", "ms", "in_flight", "gzip", "sorted"});    // as {1000, 100, 1, 0}, sorted
+BENCHMARK(BM_AsyncBatchStrategy)->Args({5000, 100, 1, 0, 1})->ArgNames({"lines", "ms", "in_flight", "gzip", "sorted"});    // as {5000, 100, 1, 0}, sorted
+BENCHMARK(BM_AsyncBatchStrategy)->Args({10000, 100, 1, 0, 1})->ArgNames({"lines", "ms", "in_flight", "gzip", "sorted"});   // as {10000, 100, 1, 0}, sorted
 
 // Helper function to print executive summary
 void print_executive_summary() {
@@ -432,6 +471,9 @@ void print_executive_summary() {
         std::cout << "\nBest performing strategy (by insert rate):" << std::endl;
         std::cout << "  Batch size: " << best_it->batch_size << " lines" << std::endl;
         std::cout << "  Time window: " << best_it->batch_time_ms << " ms" << std::endl;
+        std::cout << "  Requests in flight: " << best_it->max_in_flight << std::endl;
+        std::cout << "  Gzip: " << (best_it->gzip ? "yes" : "no") << std::endl;
+        std::cout << "  Sorted: " << (best_it->sorted ? "yes" : "no") << std::endl;
         std::cout << "  Insert rate: " << std::fixed << std::setprecision(0) << best_it->actual_throughput_req_s << " lines/s" << std::endl;
         std::cout << "  HTTP rate: " << std::fixed << std::setprecision(1) << best_it->http_request_rate_req_s << " req/s" << std::endl;
         std::cout << "  HTTP throughput: " << std::fixed << std::setprecision(2) << (best_it->http_bytes_rate_bytes_s / (1024.0 * 1024.0)) << " MB/s" << std::endl;
@@ -451,24 +493,28 @@ void print_summary_table() {
         return;
     }
     
-    std::cout << "\n" << std::string(150, '=') << std::endl;
+    std::cout << "\n" << std::string(182, '=') << std::endl;
     std::cout << "BATCHING STRATEGY PERFORMANCE SUMMARY" << std::endl;
-    std::cout << std::string(150, '=') << std::endl;
+    std::cout << std::string(182, '=') << std::endl;
     
     // Table header
     std::cout << std::left 
               << std::setw(10) << "Batch"
               << std::setw(10) << "Time"
+              << std::setw(10) << "In flight"
               << std::setw(15) << "API (lines/s)"
               << std::setw(15) << "HTTP (req/s)"
+              << std::setw(6) << "Gzip"
+              << std::setw(8) << "Sorted"
               << std::setw(18) << "HTTP (MB/s)"
+              << std::setw(18) << "Wire (MB/s)"
               << std::setw(15) << "Insert (lines/s)"
               << std::setw(15) << "HTTP Success/Fail"
               << std::setw(12) << "Lines"
               << std::setw(10) << "Efficiency"
               << std::setw(10) << "Status"
               << std::endl;
-    std::cout << std::string(150, '-') << std::endl;
+    std::cout << std::string(182, '-') << std::endl;
     
     // Sort by actual throughput (descending)
     std::sort(benchmark_results.begin(), benchmark_results.end(),
@@ -485,15 +531,20 @@ void print_summary_table() {
         
         // Format bytes rate as MB/s
         double mb_per_sec = result.http_bytes_rate_bytes_s / (1024.0 * 1024.0);
+        double wire_mb_per_sec = result.http_wire_rate_bytes_s / (1024.0 * 1024.0);
         
         std::string status = result.aborted ? "ABORTED" : "OK";
         
         std::cout << std::left 
                   << std::setw(10) << result.batch_size
                   << std::setw(10) << result.batch_time_ms
+                  << std::setw(10) << result.max_in_flight
                   << std::setw(15) << std::fixed << std::setprecision(0) << result.submit_rate_req_s
                   << std::setw(15) << std::fixed << std::setprecision(0) << result.http_request_rate_req_s
+                  << std::setw(6) << (result.gzip ? "yes" : "no")
+                  << std::setw(8) << (result.sorted ? "yes" : "no")
                   << std::setw(18) << std::fixed << std::setprecision(2) << mb_per_sec
+                  << std::setw(18) << std::fixed << std::setprecision(2) << wire_mb_per_sec
                   << std::setw(15) << std::fixed << std::setprecision(0) << result.actual_throughput_req_s
                   << std::setw(15) << http_status
                   << std::setw(12) << (std::to_string(result.actual_count) + "/" + std::to_string(result.submitted) + " lines")
@@ -502,12 +553,15 @@ void print_summary_table() {
                   << std::endl;
     }
     
-    std::cout << std::string(150, '=') << std::endl;
+    std::cout << std::string(182, '=') << std::endl;
     std::cout << "\nNotes:" << std::endl;
     std::cout << "  - Each test is limited to max 10k lines and max 10 seconds for fair comparison" << std::endl;
+    std::cout << "  - In flight = http_config::max_in_flight, the number of requests allowed on the wire at once" << std::endl;
     std::cout << "  - API (lines/s) = async_db.insert() call rate (submission rate of lines)" << std::endl;
     std::cout << "  - HTTP (req/s) = actual HTTP request rate (from observable events)" << std::endl;
     std::cout << "  - HTTP (MB/s) = bytes sent per second (from HTTP events)" << std::endl;
+    std::cout << "  - Wire (MB/s) = request body bytes transmitted per second, after gzip if enabled" << std::endl;
+    std::cout << "  - Sorted = batch_config::sort_by_series, lines grouped by series and ordered by time in each request" << std::endl;
     std::cout << "  - Insert (lines/s) = verified database insert rate of lines (from query count)" << std::endl;
     std::cout << "  - HTTP Success/Fail = number of successful/failed HTTP requests" << std::endl;
     std::cout << "  - Status: ABORTED = count stopped increasing (messages may have been dropped)" << std::endl;
@@ -1,5 +1,16 @@
 #include <benchmark/benchmark.h>
 #include <influxdb_line.h>
+#include <format_float.h>
+#include <influxdb_schema.h>
+#include <influxdb_series_cache.h>
+#include <influxdb_column_batch.h>
+#include <gzip.h>
+#include <series_sort.h>
+#include <point_coalesce.h>
+#include <point_aggregate.h>
+#include <cstdint>
+#include <vector>
+#include <sstream>
 #include <string>
 
 // Benchmark the library's key_value_pairs formatting.
@@ -33,5 +44,279 @@ static void BM_FormatCombined(benchmark::State& state) {
 }
 BENCHMARK(BM_FormatCombined);
 
-BENCHMARK_MAIN();
+// Benchmark the shortest round-trip float formatter on its own.
+static void BM_FormatFloat(benchmark::State& state) {
+    char buffer[influxdb::utility::max_float_chars];
+    double value = 0.1;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(influxdb::utility::format_float(value, buffer));
+        value += 1.0 / 3.0;
+    }
+}
+BENCHMARK(BM_FormatFloat);
+
+// Baseline for BM_FormatFloat: the previous precision-probing loop.
+static void BM_FormatFloatProbing(benchmark::State& state) {
+    double value = 0.1;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(influxdb::utility::detail::format_float_probing(value));
+        value += 1.0 / 3.0;
+    }
+}
+BENCHMARK(BM_FormatFloatProbing);
+
+// Cost of one integer field, written straight into the pairs' buffer.
+static void BM_FormatIntField(benchmark::State& state) {
+    long long value = 1234567;
+    for (auto _ : state) {
+        auto kvp = influxdb::api::key_value_pairs("field1", value++);
+        benchmark::DoNotOptimize(kvp.get());
+    }
+}
+BENCHMARK(BM_FormatIntField);
+
+// Baseline for BM_FormatIntField: the previous add() path with a
+// std::ostringstream per field.
+static void BM_FormatIntFieldStream(benchmark::State& state) {
+    long long value = 1234567;
+    for (auto _ : state) {
+        influxdb::utility::throw_on_invalid_identifier("field1");
+        std::string res;
+        std::ostringstream out;
+        out << "field1" << '=' << value++ << 'i';
+        res += out.str();
+        benchmark::DoNotOptimize(res);
+    }
+}
+BENCHMARK(BM_FormatIntFieldStream);
+
+// Cost of appending a nanosecond timestamp to a line.
+static void BM_FormatTimestamp(benchmark::State& state) {
+    const std::string raw = "measurement,tag1=value1 field1=42i";
+    const influxdb::api::default_timestamp timestamp;
+    for (auto _ : state) {
+        auto l = influxdb::api::line(raw, timestamp);
+        benchmark::DoNotOptimize(l.get());
+    }
+}
+BENCHMARK(BM_FormatTimestamp);
+
+// Baseline for BM_FormatTimestamp: the previous std::ostringstream.
+static void BM_FormatTimestampStream(benchmark::State& state) {
+    const std::string raw = "measurement,tag1=value1 field1=42i";
+    const influxdb::api::default_timestamp timestamp;
+    for (auto _ : state) {
+        std::ostringstream out;
+        out << raw << ' ' << timestamp.now();
+        benchmark::DoNotOptimize(out.str());
+    }
+}
+BENCHMARK(BM_FormatTimestampStream);
+
+// Same point as BM_FormatCombined, through a compile-time schema.
+using schema_measurement = influxdb::api::schema::measurement<
+    "measurement",
+    influxdb::api::schema::tags<"tag1">,
+    influxdb::api::schema::fields<"field1", "field2">>;
+
+static void BM_FormatSchemaLine(benchmark::State& state) {
+    for (auto _ : state) {
+        auto l = schema_measurement::line("value1", 42, 3.14);
+        benchmark::DoNotOptimize(l.get());
+    }
+}
+BENCHMARK(BM_FormatSchemaLine);
+
+// Same point as BM_FormatCombined, through a series key held by the caller.
+static void BM_FormatSeriesLine(benchmark::State& state) {
+    influxdb::api::series_cache cache;
+    auto const series = cache.get("measurement", influxdb::api::key_value_pairs("tag1", "value1"));
+
+    for (auto _ : state) {
+        auto l = influxdb::api::line(series, influxdb::api::key_value_pairs("field1", 42).add("field2", 3.14));
+        benchmark::DoNotOptimize(l.get());
+    }
+}
+BENCHMARK(BM_FormatSeriesLine);
+
+// As BM_FormatSeriesLine, looking the series up by its tags for every point.
+static void BM_FormatSeriesLineLookup(benchmark::State& state) {
+    influxdb::api::series_cache cache;
+    auto const tags = influxdb::api::key_value_pairs("tag1", "value1");
+
+    for (auto _ : state) {
+        auto l = influxdb::api::line(cache.get("measurement", tags),
+                                     influxdb::api::key_value_pairs("field1", 42).add("field2", 3.14));
+        benchmark::DoNotOptimize(l.get());
+    }
+}
+BENCHMARK(BM_FormatSeriesLineLookup);
+
+// A block of points of one series: timestamps plus two field columns.
+namespace {
+    struct column_block {
+        std::vector<std::int64_t> stamps;
+        std::vector<double> usage;
+        std::vector<std::int64_t> count;
+
+        explicit column_block(std::size_t rows) {
+            for (std::size_t i = 0; i < rows; ++i) {
+                stamps.push_back(1700000000000000000LL + static_cast<std::int64_t>(i) * 1000000);
+                usage.push_back(static_cast<double>(i) / 7.0);
+                count.push_back(static_cast<std::int64_t>(i) * 3);
+            }
+        }
+    };
+
+    struct row_timestamp {
+        std::int64_t stamp;
+        std::int64_t now() const { return stamp; }
+    };
+}
+
+static void BM_FormatColumnBatch(benchmark::State& state) {
+    column_block const block(static_cast<std::size_t>(state.range(0)));
+    auto const tags = influxdb::api::key_value_pairs("tag1", "value1");
+
+    for (auto _ : state) {
+        influxdb::api::column_batch batch("measurement", tags);
+        batch.add("usage", block.usage).add("count", block.count).timestamps(block.stamps);
+        benchmark::DoNotOptimize(batch.get());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_FormatColumnBatch)->Arg(1000);
+
+// Baseline for BM_FormatColumnBatch: one key_value_pairs and line per row.
+static void BM_FormatColumnRows(benchmark::State& state) {
+    column_block const block(static_cast<std::size_t>(state.range(0)));
+    auto const tags = influxdb::api::key_value_pairs("tag1", "value1");
+
+    for (auto _ : state) {
+        influxdb::api::line lines;
+        for (std::size_t i = 0; i < block.stamps.size(); ++i) {
+            lines("measurement", tags,
+                  influxdb::api::key_value_pairs("usage", block.usage[i]).add("count", block.count[i]),
+                  row_timestamp{ block.stamps[i] });
+        }
+        benchmark::DoNotOptimize(lines.get());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_FormatColumnRows)->Arg(1000);
+
+// Cost of gzipping a formatted batch before it is sent (http_config::compression).
+// bytes_per_second counts the uncompressed input; ratio is output/input size.
+static void BM_GzipBatch(benchmark::State& state) {
+    column_block const block(static_cast<std::size_t>(state.range(0)));
+    influxdb::api::column_batch batch("measurement", influxdb::api::key_value_pairs("tag1", "value1"));
+    batch.add("usage", block.usage).add("count", block.count).timestamps(block.stamps);
+    auto const lines = batch.get();
+
+    std::size_t compressed = 0;
+    for (auto _ : state) {
+        auto body = influxdb::utility::gzip(lines, static_cast<int>(state.range(1)));
+        compressed = body.size();
+        benchmark::DoNotOptimize(body.data());
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(lines.size()));
+    state.counters["ratio"] = static_cast<double>(compressed) / static_cast<double>(lines.size());
+}
+BENCHMARK(BM_GzipBatch)->Args({1000, 1})->Args({1000, 6})->ArgNames({"lines", "level"});
+
+namespace {
+    struct fixed_timestamp {
+        long long value;
+        long long now() const { return value; }
+    };
+}
 
+// Cost of grouping a batch by series before it is sent (batch_config::sort_by_series):
+// lines of range(1) series interleaved in arrival order, one timestamp per round.
+static void BM_SortBatch(benchmark::State& state) {
+    auto const lines = static_cast<int>(state.range(0));
+    auto const series = static_cast<int>(state.range(1));
+
+    std::string arrived;
+    for (int i = 0; i < lines; ++i) {
+        arrived += influxdb::api::line("measurement",
+            influxdb::api::key_value_pairs("host", i % series),
+            influxdb::api::key_value_pairs("usage", 0.5).add("count", i),
+            fixed_timestamp{ 1700000000000000000LL + i / series }).get();
+        arrived += '\n';
+    }
+
+    influxdb::utility::series_sorter sorter;
+    std::string batch;
+    for (auto _ : state) {
+        state.PauseTiming();
+        batch = arrived;
+        state.ResumeTiming();
+        sorter.sort(batch);
+        benchmark::DoNotOptimize(batch.data());
+    }
+    state.SetItemsProcessed(state.iterations() * lines);
+    state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(arrived.size()));
+}
+BENCHMARK(BM_SortBatch)->Args({10000, 1000})->Args({50000, 1000})->ArgNames({"lines", "series"});
+
+// Cost of merging the lines that write the same point (batch_config::coalesce):
+// 1000 interleaved series, each point written range(1) times in a row of rounds.
+static void BM_CoalesceBatch(benchmark::State& state) {
+    auto const lines = static_cast<int>(state.range(0));
+    auto const writes = static_cast<int>(state.range(1));
+    constexpr int series = 1000;
+
+    std::string arrived;
+    for (int i = 0; i < lines; ++i) {
+        arrived += influxdb::api::line("measurement",
+            influxdb::api::key_value_pairs("host", i % series),
+            influxdb::api::key_value_pairs("usage", 0.5).add("count", i),
+            fixed_timestamp{ 1700000000000000000LL + i / series / writes }).get();
+        arrived += '\n';
+    }
+
+    influxdb::utility::point_coalescer coalescer;
+    std::string batch;
+    for (auto _ : state) {
+        state.PauseTiming();
+        batch = arrived;
+        state.ResumeTiming();
+        benchmark::DoNotOptimize(coalescer.coalesce(batch));
+    }
+    state.SetItemsProcessed(state.iterations() * lines);
+    state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(arrived.size()));
+}
+BENCHMARK(BM_CoalesceBatch)->Args({10000, 1})->Args({10000, 4})->ArgNames({"lines", "writes"});
+
+// Cost of downsampling (db_config::aggregate): range(1) series sampled at 1 kHz
+// with two fields, 10000 lines added to 1-second windows and the windows popped.
+static void BM_AggregatePoints(benchmark::State& state) {
+    auto const lines = static_cast<int>(state.range(0));
+    auto const series = static_cast<int>(state.range(1));
+
+    std::vector<std::string> arrived;
+    for (int i = 0; i < lines; ++i) {
+        arrived.push_back(influxdb::api::line("measurement",
+            influxdb::api::key_value_pairs("host", i % series),
+            influxdb::api::key_value_pairs("usage", 0.5 + i % 7).add("count", i),
+            fixed_timestamp{ 1700000000000000000LL + (i / series) * 1000000LL }).get());
+    }
+
+    influxdb::utility::point_aggregator aggregator(influxdb::api::aggregate_config(1000));
+    std::string aggregate;
+    unsigned points = 0;
+    for (auto _ : state) {
+        auto const now = influxdb::utility::point_aggregator::clock::now();
+        for (auto const& l : arrived) {
+            aggregator.add(l, now);
+        }
+        while (aggregator.pop(aggregate, points, now, true)) {
+            benchmark::DoNotOptimize(aggregate.data());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * lines);
+}
+BENCHMARK(BM_AggregatePoints)->Args({10000, 10})->Args({10000, 1000})->ArgNames({"lines", "series"});
+
+BENCHMARK_MAIN();
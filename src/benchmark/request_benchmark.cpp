@@ -0,0 +1,124 @@
+#include <benchmark/benchmark.h>
+#include <influxdb_raw_request.h>
+#include <cpprest/http_msg.h>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Building HTTP requests without sending them: the per-request setup cost
+// of raw::db, with basic authentication enabled.
+
+using namespace web;
+using namespace web::http;
+
+namespace {
+    const std::string username = "benchmark_user";
+    const std::string password = "benchmark_password";
+    const utility::string_t base = U("http://localhost:8086");
+    const std::string lines = "measurement,tag1=value1 field1=42i,field2=3.14 1700000000000000000";
+
+    // The previous request_from: credentials encoded on every request
+    http_request request_from(uri const& target, std::string const& body) {
+        http_request request;
+
+        request.set_request_uri(target);
+        request.set_method(methods::POST);
+
+        auto auth = username + ":" + password;
+        std::vector<unsigned char> bytes(auth.begin(), auth.end());
+        request.headers().add(header_names::authorization, U("Basic ") + utility::conversions::to_base64(bytes));
+
+        request.set_body(body);
+        return request;
+    }
+}
+
+static void BM_RequestInsert(benchmark::State& state) {
+    auto const writes = influxdb::raw::write_template(uri(base), U("benchmark_db"), influxdb::raw::basic_authorization(username, password));
+
+    for (auto _ : state) {
+        auto request = writes.insert(lines);
+        benchmark::DoNotOptimize(request);
+    }
+}
+BENCHMARK(BM_RequestInsert);
+
+// Baseline for BM_RequestInsert
+static void BM_RequestInsertUncached(benchmark::State& state) {
+    uri_builder builder(base);
+    builder.append(U("/write"));
+    builder.append_query(U("db"), U("benchmark_db"));
+    auto const target = builder.to_uri();
+
+    for (auto _ : state) {
+        auto request = request_from(target, lines);
+        benchmark::DoNotOptimize(request);
+    }
+}
+BENCHMARK(BM_RequestInsertUncached);
+
+static void BM_RequestQuery(benchmark::State& state) {
+    auto const queries = influxdb::raw::query_template(influxdb::raw::basic_authorization(username, password));
+    const utility::string_t query = U("select count(*) from benchmark_db..measurement");
+
+    for (auto _ : state) {
+        auto request = queries.query(query);
+        benchmark::DoNotOptimize(request);
+    }
+}
+BENCHMARK(BM_RequestQuery);
+
+// Baseline for BM_RequestQuery: a uri_builder per query
+static void BM_RequestQueryUncached(benchmark::State& state) {
+    const utility::string_t query = U("select count(*) from benchmark_db..measurement");
+
+    for (auto _ : state) {
+        uri_builder builder(U("/query"));
+        builder.append_query(U("q"), query);
+        auto request = request_from(builder.to_string(), "");
+        benchmark::DoNotOptimize(request);
+    }
+}
+BENCHMARK(BM_RequestQueryUncached);
+
+// A full batch (50000 lines by default) handed to the request body.
+// Both variants build the batch first; Copy passes it as an lvalue
+// like the previous const& insert path, Move hands it over.
+static std::string make_batch(std::size_t count) {
+    std::string batch;
+    batch.reserve(count * (lines.size() + 1));
+    for (std::size_t i = 0; i < count; ++i) {
+        batch += lines;
+        batch += '\n';
+    }
+    return batch;
+}
+
+static void BM_RequestInsertBatchCopy(benchmark::State& state) {
+    auto const writes = influxdb::raw::write_template(uri(base), U("benchmark_db"), utility::string_t());
+    auto const prototype = make_batch(static_cast<std::size_t>(state.range(0)));
+
+    for (auto _ : state) {
+        std::string batch = prototype;
+        auto request = writes.insert(static_cast<std::string const&>(batch));
+        benchmark::DoNotOptimize(request);
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(prototype.size()));
+}
+BENCHMARK(BM_RequestInsertBatchCopy)->Arg(50000);
+
+static void BM_RequestInsertBatchMove(benchmark::State& state) {
+    auto const writes = influxdb::raw::write_template(uri(base), U("benchmark_db"), utility::string_t());
+    auto const prototype = make_batch(static_cast<std::size_t>(state.range(0)));
+
+    for (auto _ : state) {
+        std::string batch = prototype;
+        auto request = writes.insert(std::move(batch));
+        benchmark::DoNotOptimize(request);
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(prototype.size()));
+}
+BENCHMARK(BM_RequestInsertBatchMove)->Arg(50000);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,186 @@
+#include <benchmark/benchmark.h>
+#include <influxdb_line.h>
+#include <influxdb_raw_db_utf8.h>
+#include <influxdb_simple_async_api.h>
+#include <cpprest/http_listener.h>
+#include <rxcpp/rx.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// The async API against a local HTTP sink instead of InfluxDB: the sink
+// answers every /write with 204 and counts the lines, so the benchmarks
+// measure the client's batching and HTTP path, not the database.
+
+using namespace influxdb::api;
+using namespace std::string_literals;
+
+namespace {
+    const std::string SINK_URL = std::getenv("SINK_URL") ? std::getenv("SINK_URL") : "http://127.0.0.1:18086"s;
+    constexpr int LINES = 100000;
+
+    class sink {
+        web::http::experimental::listener::http_listener listener;
+
+    public:
+        std::atomic<unsigned long long> lines{0};
+
+        sink() : listener(utility::conversions::to_string_t(SINK_URL)) {
+            listener.support(web::http::methods::POST, [this](web::http::http_request request) {
+                request.extract_utf8string(true).then([this, request](std::string body) mutable {
+                    lines.fetch_add(std::count(body.begin(), body.end(), '\n'), std::memory_order_relaxed);
+                    request.reply(web::http::status_codes::NoContent);
+                });
+            });
+            listener.open().wait();
+        }
+
+        ~sink() {
+            listener.close().wait();
+        }
+
+        // true if all lines arrived in time
+        bool wait_for(unsigned long long expected) {
+            auto const deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+            while (lines.load() < expected) {
+                if (std::chrono::steady_clock::now() > deadline)
+                    return false;
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+            }
+            return true;
+        }
+    };
+
+    sink& the_sink() {
+        static sink instance;
+        return instance;
+    }
+
+    line make_line(int i) {
+        return line("sink", key_value_pairs("tag1", i % 100), key_value_pairs("field1", i).add("field2", 3.14));
+    }
+
+    // The previous batching pipeline: a subject per line, windowed by time
+    // or count on an event loop and concatenated with scan()
+    class rx_batcher {
+        influxdb::raw::db_utf8 db;
+        rxcpp::subjects::subject<std::string> subj;
+        rxcpp::composite_subscription listener;
+
+    public:
+        rx_batcher(unsigned max_lines, unsigned max_ms)
+            : db(SINK_URL, "sink") {
+            auto coordination = rxcpp::observe_on_event_loop();
+            listener = subj.get_observable()
+                .window_with_time_or_count(std::chrono::milliseconds(max_ms), static_cast<int>(max_lines), coordination)
+                .subscribe([this, coordination](rxcpp::observable<std::string> window) {
+                    window.scan(
+                        std::make_shared<std::string>(),
+                        [](std::shared_ptr<std::string> const& w, std::string const& v) {
+                            *w += v;
+                            *w += '\n';
+                            return w;
+                        })
+                    .start_with(std::make_shared<std::string>())
+                    .last()
+                    .observe_on(coordination)
+                    .subscribe([this](std::shared_ptr<std::string> const& w) {
+                        if (!w->empty())
+                            db.insert_async(std::move(*w), [](http_result const&) {});
+                    });
+                });
+        }
+
+        ~rx_batcher() {
+            listener.unsubscribe();
+            db.wait_for_in_flight();
+        }
+
+        void insert(line&& l) {
+            subj.get_subscriber().on_next(l.take());
+        }
+    };
+}
+
+static void BM_SinkBatcher(benchmark::State& state) {
+    auto& target = the_sink();
+    unsigned const max_lines = static_cast<unsigned>(state.range(0));
+
+    for (auto _ : state) {
+        auto const before = target.lines.load();
+        {
+            influxdb::async_api::simple_db db(SINK_URL, "sink", db_config(batch_config(max_lines, 100)));
+            for (int i = 0; i < LINES; ++i)
+                db.insert(make_line(i));
+
+            if (!target.wait_for(before + LINES)) {
+                state.SkipWithError("lines did not arrive at the sink");
+                return;
+            }
+        }
+    }
+    state.counters["lines_per_s"] = benchmark::Counter(static_cast<double>(state.iterations()) * LINES, benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_SinkBatcher)->Arg(1000)->Arg(10000)->ArgNames({"lines"})->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// The same, from 4 threads into 1 to 8 workers: lines of the sink's 100
+// series are spread over the workers, each batching and sending on its own
+static void BM_SinkWorkers(benchmark::State& state) {
+    auto& target = the_sink();
+    constexpr int threads = 4;
+
+    db_config config(batch_config(1000, 100));
+    config.queue.workers = static_cast<unsigned>(state.range(0));
+
+    for (auto _ : state) {
+        auto const before = target.lines.load();
+        {
+            influxdb::async_api::simple_db db(SINK_URL, "sink", config);
+            std::vector<std::thread> producers;
+            for (int t = 0; t < threads; ++t) {
+                producers.emplace_back([&db, t] {
+                    for (int i = t; i < LINES; i += threads)
+                        db.insert(make_line(i));
+                });
+            }
+            for (auto& producer : producers)
+                producer.join();
+
+            if (!target.wait_for(before + LINES)) {
+                state.SkipWithError("lines did not arrive at the sink");
+                return;
+            }
+        }
+    }
+    state.counters["lines_per_s"] = benchmark::Counter(static_cast<double>(state.iterations()) * LINES, benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_SinkWorkers)->RangeMultiplier(2)->Range(1, 8)->ArgNames({"workers"})->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// Baseline for BM_SinkBatcher
+static void BM_SinkRxPipeline(benchmark::State& state) {
+    auto& target = the_sink();
+    unsigned const max_lines = static_cast<unsigned>(state.range(0));
+
+    for (auto _ : state) {
+        auto const before = target.lines.load();
+        {
+            rx_batcher db(max_lines, 100);
+            for (int i = 0; i < LINES; ++i)
+                db.insert(make_line(i));
+
+            if (!target.wait_for(before + LINES)) {
+                state.SkipWithError("lines did not arrive at the sink");
+                return;
+            }
+        }
+    }
+    state.counters["lines_per_s"] = benchmark::Counter(static_cast<double>(state.iterations()) * LINES, benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_SinkRxPipeline)->Arg(1000)->Arg(10000)->ArgNames({"lines"})->Unit(benchmark::kMillisecond)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -19,6 +19,7 @@
 #include <cassert>
 #include <string>
 #include <iostream>
+#include <utility>
 
 extern "C" {
 
@@ -144,16 +145,104 @@ extern "C" {
         void* line_ptr = influx_c_rest_lines_get_internal(lines);
         influxdb::api::line* line_obj = static_cast<influxdb::api::line*>(line_ptr);
         influxdb::api::line line_with_timestamp(line_obj->get(), self->timestamp);
-        self->asyncdb->insert(line_with_timestamp);
+        self->asyncdb->insert(std::move(line_with_timestamp));
     }
 
-    extern "C" INFLUX_C_REST void influx_c_rest_async_wait_quiet_ms(influx_c_rest_async_t * self, unsigned quiet_period_ms) {
+    extern "C" INFLUX_C_REST int influx_c_rest_async_try_insert(influx_c_rest_async_t * self, const char* line) {
+        assert(self);
+        assert(self->asyncdb.get());
+        assert(line);
+        return self->asyncdb->try_insert(influxdb::api::line(std::string(line))) ? 0 : 1;
+    }
+
+    extern "C" INFLUX_C_REST size_t influx_c_rest_async_queue_depth(influx_c_rest_async_t * self) {
+        assert(self);
+        assert(self->asyncdb.get());
+        return self->asyncdb->queue_depth();
+    }
+
+    extern "C" INFLUX_C_REST unsigned long long influx_c_rest_async_dropped(influx_c_rest_async_t * self) {
+        assert(self);
+        assert(self->asyncdb.get());
+        return self->asyncdb->dropped();
+    }
+
+    extern "C" INFLUX_C_REST unsigned long long influx_c_rest_async_spill_pending_bytes(influx_c_rest_async_t * self) {
+        assert(self);
+        assert(self->asyncdb.get());
+        return self->asyncdb->spill_stats().pending_bytes;
+    }
+
+    extern "C" INFLUX_C_REST void influx_c_rest_async_metrics(influx_c_rest_async_t * self, influx_c_rest_async_metrics_t * metrics) {
+        assert(self);
+        assert(self->asyncdb.get());
+        assert(metrics);
+        auto const m = self->asyncdb->metrics();
+        metrics->lines_enqueued = m.lines_enqueued;
+        metrics->lines_sent = m.lines_sent;
+        metrics->lines_failed = m.lines_failed;
+        metrics->lines_spilled = m.lines_spilled;
+        metrics->lines_dropped = m.lines_dropped;
+        metrics->lines_coalesced = m.lines_coalesced;
+        metrics->lines_aggregated = m.lines_aggregated;
+        metrics->queue_depth = m.queue_depth;
+        metrics->queue_capacity = m.queue_capacity;
+        metrics->batch_max_lines = m.batch_max_lines;
+        metrics->batch_max_time_ms = m.batch_max_time_ms;
+        metrics->batches = m.batch_lines.count();
+        metrics->mean_batch_lines = m.batch_lines.mean();
+        metrics->latency_p50_us = m.latency_us.percentile(0.5);
+        metrics->latency_p99_us = m.latency_us.percentile(0.99);
+        metrics->latency_max_us = m.latency_us.max();
+    }
+
+    extern "C" INFLUX_C_REST void influx_c_rest_async_on_http_event(influx_c_rest_async_t * self, influx_c_rest_http_event_fn fn, void* context, unsigned sample_every) {
+        assert(self);
+        assert(self->asyncdb.get());
+        if (!fn) {
+            self->asyncdb->on_http_event(nullptr);
+            return;
+        }
+
+        self->asyncdb->on_http_event([fn, context](influxdb::api::http_event const& e) {
+            influx_c_rest_http_event_t event;
+            event.timestamp_ns = e.timestamp_ns;
+            event.bytes_sent = e.bytes_sent;
+            event.bytes_on_wire = e.bytes_on_wire;
+            event.bytes_received = e.bytes_received;
+            event.duration_us = e.duration_us;
+            event.status_code = e.status_code;
+            event.success = e.success ? 1 : 0;
+            // interned messages are null-terminated and never freed
+            event.error = influxdb::api::http_error_message(e.error).data();
+            fn(&event, context);
+        }, sample_every);
+    }
+
+    extern "C" INFLUX_C_REST void influx_c_rest_async_wait(influx_c_rest_async_t * self) {
+        assert(self);
+        assert(self->asyncdb.get());
+        try {
+            self->asyncdb->wait_for_submission();
+        } catch (std::exception& e) {
+            std::cerr << e.what() << std::endl;
+        }
+    }
+
+    extern "C" INFLUX_C_REST int influx_c_rest_async_wait_quiet_ms(influx_c_rest_async_t * self, unsigned timeout_ms) {
         assert(self);
         assert(self->asyncdb.get());
         try {
-            self->asyncdb->wait_for_submission(std::chrono::milliseconds(quiet_period_ms));
+            return self->asyncdb->wait_for_submission(std::chrono::milliseconds(timeout_ms)) ? 0 : 1;
         } catch (std::exception& e) {
             std::cerr << e.what() << std::endl;
+            return 1;
         }
     }
+
+    extern "C" INFLUX_C_REST int influx_c_rest_async_flush(influx_c_rest_async_t * self, unsigned timeout_ms) {
+        assert(self);
+        assert(self->asyncdb.get());
+        return self->asyncdb->flush(std::chrono::milliseconds(timeout_ms)) ? 0 : 1;
+    }
 }
@@ -6,6 +6,8 @@
 
 #include "influx_c_rest_api.h"
 
+#include <stddef.h>
+
 #if defined(__cplusplus)
 extern "C" {
 #endif
@@ -29,8 +31,59 @@ extern "C" {
     INFLUX_C_REST void influx_c_rest_async_insert_lines(influx_c_rest_async_t * self, influx_c_rest_lines_t * lines);
     INFLUX_C_REST void influx_c_rest_async_insert_lines_default_timestamp(influx_c_rest_async_t * self, influx_c_rest_lines_t * lines);
 
+    /* non-blocking insert: 0 if the line was queued, 1 if the queue was full */
+    INFLUX_C_REST int influx_c_rest_async_try_insert(influx_c_rest_async_t * self, const char* line);
+
+    /* queue state */
+    INFLUX_C_REST size_t influx_c_rest_async_queue_depth(influx_c_rest_async_t * self);
+    INFLUX_C_REST unsigned long long influx_c_rest_async_dropped(influx_c_rest_async_t * self);
+    /* bytes in the spill queue waiting to be replayed */
+    INFLUX_C_REST unsigned long long influx_c_rest_async_spill_pending_bytes(influx_c_rest_async_t * self);
+
+    /* a snapshot of the pipeline's counters, latencies in microseconds */
+    typedef struct _influx_c_rest_async_metrics_t {
+        unsigned long long lines_enqueued;
+        unsigned long long lines_sent;
+        unsigned long long lines_failed;
+        unsigned long long lines_spilled;
+        unsigned long long lines_dropped;
+        unsigned long long lines_coalesced;
+        unsigned long long lines_aggregated;
+        size_t queue_depth;
+        size_t queue_capacity;
+        unsigned batch_max_lines;
+        unsigned batch_max_time_ms;
+        unsigned long long batches;
+        double mean_batch_lines;
+        unsigned long long latency_p50_us;
+        unsigned long long latency_p99_us;
+        unsigned long long latency_max_us;
+    } influx_c_rest_async_metrics_t;
+    INFLUX_C_REST void influx_c_rest_async_metrics(influx_c_rest_async_t * self, influx_c_rest_async_metrics_t * metrics);
+
+    /* the outcome of a request; error is "" on success and stays valid for the life of the process */
+    typedef struct _influx_c_rest_http_event_t {
+        long long timestamp_ns;
+        unsigned long long bytes_sent;
+        unsigned long long bytes_on_wire;
+        unsigned long long bytes_received;
+        unsigned duration_us;
+        unsigned status_code;
+        int success;
+        const char* error;
+    } influx_c_rest_http_event_t;
+    typedef void (*influx_c_rest_http_event_fn)(const influx_c_rest_http_event_t* event, void* context);
+    /* calls fn for every failed request and one in sample_every successful ones; NULL unsubscribes */
+    INFLUX_C_REST void influx_c_rest_async_on_http_event(influx_c_rest_async_t * self, influx_c_rest_http_event_fn fn, void* context, unsigned sample_every);
+
     /* synchronization */
-    INFLUX_C_REST void influx_c_rest_async_wait_quiet_ms(influx_c_rest_async_t * self, unsigned quiet_period_ms);
+    /* waits until all inserted lines are acknowledged, failed, dropped or spilled, returns at once if none are pending */
+    INFLUX_C_REST void influx_c_rest_async_wait(influx_c_rest_async_t * self);
+    /* the same, for at most timeout_ms (0 for no limit): 0 when they are resolved, 1 if timeout_ms passed first */
+    INFLUX_C_REST int influx_c_rest_async_wait_quiet_ms(influx_c_rest_async_t * self, unsigned timeout_ms);
+    /* sends the partial batches and waits for all inserted lines to be acknowledged, failed, dropped or spilled:
+       0 when they are, 1 if timeout_ms (0 for no limit) passed first */
+    INFLUX_C_REST int influx_c_rest_async_flush(influx_c_rest_async_t * self, unsigned timeout_ms);
 
 #if defined(__cplusplus)
 }
@@ -46,6 +46,87 @@ extern "C" {
         self->config.batch.max_time_ms = max_time_ms;
     }
 
+    INFLUX_C_REST void influx_c_rest_config_set_batch_max_bytes(influx_c_rest_config_t * self, size_t max_bytes) {
+        assert(self);
+        self->config.batch.max_bytes = max_bytes;
+    }
+
+    INFLUX_C_REST void influx_c_rest_config_set_batch_adaptive(influx_c_rest_config_t * self, int enabled, unsigned target_latency_ms) {
+        assert(self);
+        self->config.batch.adaptive.enabled = enabled != 0;
+        self->config.batch.adaptive.target_latency_ms = target_latency_ms;
+    }
+
+    INFLUX_C_REST void influx_c_rest_config_set_batch_sort_by_series(influx_c_rest_config_t * self, int sort_by_series) {
+        assert(self);
+        self->config.batch.sort_by_series = sort_by_series != 0;
+    }
+
+    INFLUX_C_REST void influx_c_rest_config_set_batch_coalesce(influx_c_rest_config_t * self, int coalesce) {
+        assert(self);
+        self->config.batch.coalesce = coalesce != 0;
+    }
+
+    INFLUX_C_REST void influx_c_rest_config_set_queue_capacity(influx_c_rest_config_t * self, size_t capacity) {
+        assert(self);
+        self->config.queue.capacity = capacity;
+    }
+
+    INFLUX_C_REST void influx_c_rest_config_set_queue_workers(influx_c_rest_config_t * self, unsigned workers) {
+        assert(self);
+        self->config.queue.workers = workers;
+    }
+
+    INFLUX_C_REST void influx_c_rest_config_set_queue_shutdown_timeout_ms(influx_c_rest_config_t * self, unsigned shutdown_timeout_ms) {
+        assert(self);
+        self->config.queue.shutdown_timeout_ms = shutdown_timeout_ms;
+    }
+
+    INFLUX_C_REST void influx_c_rest_config_set_spill(influx_c_rest_config_t * self, const char* directory, size_t max_bytes) {
+        assert(self);
+        assert(directory);
+        self->config.spill = influxdb::api::spill_config(directory, max_bytes);
+    }
+
+    INFLUX_C_REST void influx_c_rest_config_set_aggregate(influx_c_rest_config_t * self, unsigned window_ms) {
+        assert(self);
+        self->config.aggregate.window_ms = window_ms;
+    }
+
+    INFLUX_C_REST void influx_c_rest_config_set_aggregate_grace_ms(influx_c_rest_config_t * self, unsigned grace_ms) {
+        assert(self);
+        self->config.aggregate.grace_ms = grace_ms;
+    }
+
+    INFLUX_C_REST void influx_c_rest_config_set_aggregate_max_series(influx_c_rest_config_t * self, size_t max_series) {
+        assert(self);
+        self->config.aggregate.max_series = max_series;
+    }
+
+    INFLUX_C_REST void influx_c_rest_config_add_aggregate_measurement(influx_c_rest_config_t * self, const char* measurement) {
+        assert(self);
+        assert(measurement);
+        self->config.aggregate.measurements.emplace_back(measurement);
+    }
+
+    INFLUX_C_REST void influx_c_rest_config_set_queue_overflow(influx_c_rest_config_t * self, influx_c_rest_overflow_policy_t overflow) {
+        assert(self);
+        switch (overflow) {
+        case INFLUX_C_REST_OVERFLOW_DROP_NEWEST:
+            self->config.queue.overflow = influxdb::api::overflow_policy::drop_newest;
+            break;
+        case INFLUX_C_REST_OVERFLOW_DROP_OLDEST:
+            self->config.queue.overflow = influxdb::api::overflow_policy::drop_oldest;
+            break;
+        case INFLUX_C_REST_OVERFLOW_FAIL:
+            self->config.queue.overflow = influxdb::api::overflow_policy::fail;
+            break;
+        default:
+            self->config.queue.overflow = influxdb::api::overflow_policy::block;
+            break;
+        }
+    }
+
     INFLUX_C_REST void influx_c_rest_config_set_http_keepalive(influx_c_rest_config_t * self, int keepalive) {
         assert(self);
         self->config.http.keepalive = (keepalive != 0);
@@ -61,6 +142,16 @@ extern "C" {
         self->config.http.max_connections_per_host = max_connections;
     }
 
+    INFLUX_C_REST void influx_c_rest_config_set_http_max_in_flight(influx_c_rest_config_t * self, unsigned max_in_flight) {
+        assert(self);
+        self->config.http.max_in_flight = max_in_flight;
+    }
+
+    INFLUX_C_REST void influx_c_rest_config_set_http_compression(influx_c_rest_config_t * self, int enabled, unsigned min_bytes, int level) {
+        assert(self);
+        self->config.http.compression = influxdb::api::compression_config(enabled != 0, min_bytes, level);
+    }
+
     INFLUX_C_REST void* influx_c_rest_config_get_internal(influx_c_rest_config_t * self) {
         assert(self);
         return &self->config;
@@ -6,12 +6,22 @@
 
 #include "influx_c_rest_api.h"
 
+#include <stddef.h>
+
 #if defined(__cplusplus)
 extern "C" {
 #endif
 
     typedef struct _influx_c_rest_config_t influx_c_rest_config_t;
 
+    /* what the async inserts do when the queue is full */
+    typedef enum {
+        INFLUX_C_REST_OVERFLOW_BLOCK = 0,
+        INFLUX_C_REST_OVERFLOW_DROP_NEWEST = 1,
+        INFLUX_C_REST_OVERFLOW_DROP_OLDEST = 2,
+        INFLUX_C_REST_OVERFLOW_FAIL = 3
+    } influx_c_rest_overflow_policy_t;
+
     /* lifetime */
     INFLUX_C_REST influx_c_rest_config_t *influx_c_rest_config_new(void);
     INFLUX_C_REST void influx_c_rest_config_destroy(influx_c_rest_config_t * self);
@@ -19,11 +29,39 @@ extern "C" {
     /* batch configuration */
     INFLUX_C_REST void influx_c_rest_config_set_batch_max_lines(influx_c_rest_config_t * self, unsigned max_lines);
     INFLUX_C_REST void influx_c_rest_config_set_batch_max_time_ms(influx_c_rest_config_t * self, unsigned max_time_ms);
+    INFLUX_C_REST void influx_c_rest_config_set_batch_max_bytes(influx_c_rest_config_t * self, size_t max_bytes);
+    /* steers the batch size and interval towards target_latency_ms (0 for throughput), up to the limits above */
+    INFLUX_C_REST void influx_c_rest_config_set_batch_adaptive(influx_c_rest_config_t * self, int enabled, unsigned target_latency_ms);
+    /* groups each batch by series and orders it by timestamp before sending it */
+    INFLUX_C_REST void influx_c_rest_config_set_batch_sort_by_series(influx_c_rest_config_t * self, int sort_by_series);
+    /* merges the lines of a batch that write the same series and timestamp into one */
+    INFLUX_C_REST void influx_c_rest_config_set_batch_coalesce(influx_c_rest_config_t * self, int coalesce);
+
+    /* queue configuration */
+    INFLUX_C_REST void influx_c_rest_config_set_queue_capacity(influx_c_rest_config_t * self, size_t capacity);
+    INFLUX_C_REST void influx_c_rest_config_set_queue_overflow(influx_c_rest_config_t * self, influx_c_rest_overflow_policy_t overflow);
+    INFLUX_C_REST void influx_c_rest_config_set_queue_workers(influx_c_rest_config_t * self, unsigned workers);
+    INFLUX_C_REST void influx_c_rest_config_set_queue_shutdown_timeout_ms(influx_c_rest_config_t * self, unsigned shutdown_timeout_ms);
+
+    /* spill queue: batches the server did not take are kept in directory, up to max_bytes per worker (POSIX only:
+       on Windows, creating an async db with it fails) */
+    INFLUX_C_REST void influx_c_rest_config_set_spill(influx_c_rest_config_t * self, const char* directory, size_t max_bytes);
+
+    /* client-side downsampling: per series, each window of window_ms becomes one line of f_min, f_max, f_mean, f_count
+       and f_last fields; 0 disables it. Measurements can be added one by one, none aggregates all of them */
+    INFLUX_C_REST void influx_c_rest_config_set_aggregate(influx_c_rest_config_t * self, unsigned window_ms);
+    /* how long past a window's end its points may still arrive; later ones are sent as they are */
+    INFLUX_C_REST void influx_c_rest_config_set_aggregate_grace_ms(influx_c_rest_config_t * self, unsigned grace_ms);
+    /* series aggregated per worker, kept until destruction; lines of further series are sent as they are */
+    INFLUX_C_REST void influx_c_rest_config_set_aggregate_max_series(influx_c_rest_config_t * self, size_t max_series);
+    INFLUX_C_REST void influx_c_rest_config_add_aggregate_measurement(influx_c_rest_config_t * self, const char* measurement);
 
     /* http configuration */
     INFLUX_C_REST void influx_c_rest_config_set_http_keepalive(influx_c_rest_config_t * self, int keepalive);
     INFLUX_C_REST void influx_c_rest_config_set_http_timeout_ms(influx_c_rest_config_t * self, unsigned timeout_ms);
     INFLUX_C_REST void influx_c_rest_config_set_http_max_connections_per_host(influx_c_rest_config_t * self, unsigned max_connections);
+    INFLUX_C_REST void influx_c_rest_config_set_http_max_in_flight(influx_c_rest_config_t * self, unsigned max_in_flight);
+    INFLUX_C_REST void influx_c_rest_config_set_http_compression(influx_c_rest_config_t * self, int enabled, unsigned min_bytes, int level);
 
     /* internal access - returns pointer to internal config structure */
     INFLUX_C_REST void* influx_c_rest_config_get_internal(influx_c_rest_config_t * self);
@@ -13,6 +13,7 @@
 #include <memory>
 #include <cassert>
 #include <string>
+#include <string_view>
 #include <iostream>
 #include <cstring>
 #include <cstddef>
@@ -49,7 +50,7 @@ extern "C" {
         assert(self);
         assert(key);
         try {
-            self->kvp.add(std::string(key), value);
+            self->kvp.add(key, value);
         } catch (std::exception& e) {
             std::cerr << e.what() << std::endl;
         }
@@ -59,7 +60,7 @@ extern "C" {
         assert(self);
         assert(key);
         try {
-            self->kvp.add(std::string(key), value != 0);
+            self->kvp.add(key, value != 0);
         } catch (std::exception& e) {
             std::cerr << e.what() << std::endl;
         }
@@ -69,7 +70,7 @@ extern "C" {
         assert(self);
         assert(key);
         try {
-            self->kvp.add(std::string(key), value);
+            self->kvp.add(key, value);
         } catch (std::exception& e) {
             std::cerr << e.what() << std::endl;
         }
@@ -80,7 +81,7 @@ extern "C" {
         assert(key);
         assert(value);
         try {
-            self->kvp.add(std::string(key), std::string(value));
+            self->kvp.add(key, std::string_view(value));
         } catch (std::exception& e) {
             std::cerr << e.what() << std::endl;
         }
@@ -122,10 +123,9 @@ extern "C" {
         try {
             influx_c_rest_lines_t *res = new influx_c_rest_lines_t();
             assert(res);
-            influxdb::api::key_value_pairs tags_kvp = tags ? tags->kvp : influxdb::api::key_value_pairs();
-            influxdb::api::key_value_pairs values_kvp = values ? values->kvp : influxdb::api::key_value_pairs();
+            influxdb::api::key_value_pairs const none;
             
-            res->line_obj = influxdb::api::line(std::string(measurement), tags_kvp, values_kvp);
+            res->line_obj = influxdb::api::line(measurement, tags ? tags->kvp : none, values ? values->kvp : none);
             res->string_cached = false;
             return res;
         } catch (std::exception& e) {
@@ -138,10 +138,9 @@ extern "C" {
         assert(self);
         assert(measurement);
         try {
-            influxdb::api::key_value_pairs tags_kvp = tags ? tags->kvp : influxdb::api::key_value_pairs();
-            influxdb::api::key_value_pairs values_kvp = values ? values->kvp : influxdb::api::key_value_pairs();
+            influxdb::api::key_value_pairs const none;
 
-            self->line_obj(std::string(measurement), tags_kvp, values_kvp);
+            self->line_obj(measurement, tags ? tags->kvp : none, values ? values->kvp : none);
             self->string_cached = false;
         } catch (std::exception& e) {
             std::cerr << e.what() << std::endl;
@@ -151,7 +150,7 @@ extern "C" {
     INFLUX_C_REST const char* influx_c_rest_lines_get(influx_c_rest_lines_t * self) {
         assert(self);
         if (!self->string_cached) {
-            self->cached_string = self->line_obj.get();
+            self->cached_string.assign(self->line_obj.view());
             self->string_cached = true;
         }
         return self->cached_string.c_str();
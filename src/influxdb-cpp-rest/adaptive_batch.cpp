@@ -0,0 +1,67 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+
+#include "adaptive_batch.h"
+
+#include <algorithm>
+#include <cmath>
+
+influxdb::utility::adaptive_batch::adaptive_batch(api::batch_config const& config) :
+    config(config),
+    lines(0),
+    current_lines(0),
+    current_time_ms(0),
+    current_generation(0)
+{
+    this->config.max_lines = std::max(this->config.max_lines, 1u);
+    auto& adaptive = this->config.adaptive;
+    adaptive.min_lines = std::clamp(adaptive.min_lines, 1u, this->config.max_lines);
+    adaptive.min_time_ms = std::min(adaptive.min_time_ms, this->config.max_time_ms);
+    adaptive.decrease_factor = std::clamp(adaptive.decrease_factor, 0.0, 1.0);
+
+    lines = adaptive.enabled ? adaptive.min_lines : this->config.max_lines;
+    publish();
+}
+
+void influxdb::utility::adaptive_batch::publish()
+{
+    auto const rounded = static_cast<unsigned>(std::lround(lines));
+    current_lines.store(rounded, std::memory_order_relaxed);
+
+    if (!config.adaptive.enabled) {
+        current_time_ms.store(config.max_time_ms, std::memory_order_relaxed);
+        return;
+    }
+
+    // a smaller batch has less time to fill: the interval scales with it
+    auto const time = static_cast<double>(config.max_time_ms) * lines / config.max_lines;
+    current_time_ms.store(std::clamp(static_cast<unsigned>(std::lround(time)), config.adaptive.min_time_ms, config.max_time_ms),
+        std::memory_order_relaxed);
+}
+
+void influxdb::utility::adaptive_batch::on_response(std::uint64_t generation, std::chrono::microseconds latency, bool overloaded)
+{
+    auto const& adaptive = config.adaptive;
+    if (!adaptive.enabled) {
+        return;
+    }
+
+    bool const slow = adaptive.target_latency_ms != 0 && latency > std::chrono::milliseconds(adaptive.target_latency_ms);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (overloaded || slow) {
+        if (generation != current_generation.load(std::memory_order_relaxed)) {
+            return;
+        }
+        lines = std::max<double>(lines * adaptive.decrease_factor, adaptive.min_lines);
+        current_generation.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        lines = std::min<double>(lines + adaptive.increase_lines, config.max_lines);
+    }
+    publish();
+}
@@ -0,0 +1,52 @@
+/* * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "influxdb_config.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+namespace influxdb {
+    namespace utility {
+
+        /// The batch size and interval of the async API, steered by
+        /// adaptive_batch_config. The flushers read the current limits
+        /// without locking; responses adjust them one at a time.
+        /// Without adaptive_batch_config::enabled the limits stay those of
+        /// batch_config.
+        class adaptive_batch {
+            api::batch_config config;
+            std::mutex mutex;
+            // the batch size as a real number, so that small steps add up
+            double lines;
+            std::atomic<unsigned> current_lines;
+            std::atomic<unsigned> current_time_ms;
+            // bumped on every decrease: the responses to batches sent
+            // before it reflect the old size and must not decrease again
+            std::atomic<std::uint64_t> current_generation;
+
+            void publish();
+
+        public:
+            explicit adaptive_batch(api::batch_config const& config);
+
+            unsigned max_lines() const { return current_lines.load(std::memory_order_relaxed); }
+            std::chrono::milliseconds max_time() const {
+                return std::chrono::milliseconds(current_time_ms.load(std::memory_order_relaxed));
+            }
+
+            /// to be passed back to on_response() with the batch's outcome
+            std::uint64_t generation() const { return current_generation.load(std::memory_order_relaxed); }
+
+            /// Accounts the response to a batch sent at generation. overloaded
+            /// is for requests that failed for lack of a server.
+            void on_response(std::uint64_t generation, std::chrono::microseconds latency, bool overloaded);
+        };
+    }
+}
@@ -0,0 +1,124 @@
+/* * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace influxdb {
+    namespace utility {
+
+        /// Bounded lock-free multi-producer multi-consumer queue
+        /// (D. Vyukov's array-based design). Each cell carries a sequence
+        /// number telling producers and consumers whose turn it is, so a push
+        /// or pop is a single compare-and-swap on the shared position plus a
+        /// release store on the cell; no operation ever waits for another.
+        template <typename T>
+        class bounded_queue {
+            struct cell {
+                std::atomic<std::size_t> sequence;
+                T value;
+            };
+
+            // keeps the producers' and the consumers' position on separate cache lines
+            static constexpr std::size_t cache_line = 64;
+
+            std::unique_ptr<cell[]> cells;
+            std::size_t const mask;
+
+            alignas(cache_line) std::atomic<std::size_t> enqueue_position;
+            alignas(cache_line) std::atomic<std::size_t> dequeue_position;
+
+            static std::size_t round_up(std::size_t capacity) {
+                std::size_t size = 2;
+                while (size < capacity)
+                    size *= 2;
+                return size;
+            }
+
+        public:
+            /// capacity is rounded up to a power of two, at least 2
+            explicit bounded_queue(std::size_t capacity)
+                : cells(new cell[round_up(capacity)]),
+                  mask(round_up(capacity) - 1),
+                  enqueue_position(0),
+                  dequeue_position(0) {
+                for (std::size_t i = 0; i <= mask; ++i)
+                    cells[i].sequence.store(i, std::memory_order_relaxed);
+            }
+
+            bounded_queue(bounded_queue const&) = delete;
+            bounded_queue& operator=(bounded_queue const&) = delete;
+
+            /// moves value into the queue, unless it is full
+            bool try_push(T&& value) {
+                cell* target;
+                auto position = enqueue_position.load(std::memory_order_relaxed);
+
+                for (;;) {
+                    target = &cells[position & mask];
+                    auto const sequence = target->sequence.load(std::memory_order_acquire);
+                    auto const difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+
+                    if (difference == 0) {
+                        if (enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                            break;
+                    } else if (difference < 0) {
+                        return false;
+                    } else {
+                        position = enqueue_position.load(std::memory_order_relaxed);
+                    }
+                }
+
+                target->value = std::move(value);
+                target->sequence.store(position + 1, std::memory_order_release);
+                return true;
+            }
+
+            /// moves the oldest value out of the queue, unless it is empty
+            bool try_pop(T& value) {
+                cell* source;
+                auto position = dequeue_position.load(std::memory_order_relaxed);
+
+                for (;;) {
+                    source = &cells[position & mask];
+                    auto const sequence = source->sequence.load(std::memory_order_acquire);
+                    auto const difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position + 1);
+
+                    if (difference == 0) {
+                        if (dequeue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                            break;
+                    } else if (difference < 0) {
+                        return false;
+                    } else {
+                        position = dequeue_position.load(std::memory_order_relaxed);
+                    }
+                }
+
+                value = std::move(source->value);
+                source->sequence.store(position + mask + 1, std::memory_order_release);
+                return true;
+            }
+
+            /// the number of values in the queue, exact only while nobody pushes or pops
+            std::size_t size() const {
+                auto const dequeued = dequeue_position.load(std::memory_order_acquire);
+                auto const enqueued = enqueue_position.load(std::memory_order_acquire);
+                return enqueued > dequeued ? enqueued - dequeued : 0;
+            }
+
+            bool empty() const {
+                return size() == 0;
+            }
+
+            std::size_t capacity() const {
+                return mask + 1;
+            }
+        };
+    }
+}
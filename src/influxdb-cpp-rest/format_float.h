@@ -5,7 +5,9 @@
 
 #pragma once
 
+#include <cstddef>
 #include <cstdlib>
+#include <cstring>
 #include <iomanip>
 #include <limits>
 #include <locale>
@@ -16,6 +18,53 @@
 namespace influxdb {
     namespace utility {
 
+        /// Upper bound on the characters written by format_float(value, first)
+        /// for float, double and long double
+        constexpr std::size_t max_float_chars = 48;
+
+        namespace detail {
+
+            // Shortest round-trip engine (Ryu, see format_float.cpp). Writes
+            // exactly what format_float_probing would and returns the end of
+            // the output, or nullptr for the few values (NaN, and outputs
+            // whose closest shortest digits differ from the correctly rounded
+            // ones) that are left to the probing loop.
+            char* format_shortest(double value, char* first);
+            char* format_shortest(float value, char* first);
+
+            // Reference implementation: the smallest std::setprecision whose
+            // output parses back to the same value. Costs one stream format
+            // and one parse per candidate precision, so it only serves as the
+            // fallback for the engine above and for long double.
+            template <typename T>
+            std::string format_float_probing(T value) {
+                std::ostringstream out;
+                out.imbue(std::locale::classic());
+
+                for (int precision = 1; precision <= std::numeric_limits<T>::max_digits10; ++precision) {
+                    out.str("");
+                    out.clear();
+                    out << std::setprecision(precision) << value;
+
+                    const std::string candidate = out.str();
+                    T parsed;
+                    if constexpr (std::is_same_v<T, float>) {
+                        parsed = std::strtof(candidate.c_str(), nullptr);
+                    } else if constexpr (std::is_same_v<T, long double>) {
+                        parsed = std::strtold(candidate.c_str(), nullptr);
+                    } else {
+                        parsed = std::strtod(candidate.c_str(), nullptr);
+                    }
+
+                    if (parsed == value) {
+                        return candidate;
+                    }
+                }
+
+                return out.str();
+            }
+        }
+
         // Formats a floating-point value with the shortest decimal
         // representation that round-trips, matching std::format("{}", value)
         // and std::to_chars general format. This is implemented by hand because
@@ -23,32 +72,26 @@ namespace influxdb {
         // every toolchain we support (for example libc++ before macOS 13.3),
         // which would otherwise force a very new deployment target and compiler
         // for the whole library.
+        //
+        // Writes into [first, first + max_float_chars) and returns the end of
+        // the output; no terminating zero is written.
         template <typename T>
-        std::string format_float(T value) {
-            std::ostringstream out;
-            out.imbue(std::locale::classic());
-
-            for (int precision = 1; precision <= std::numeric_limits<T>::max_digits10; ++precision) {
-                out.str("");
-                out.clear();
-                out << std::setprecision(precision) << value;
-
-                const std::string candidate = out.str();
-                T parsed;
-                if constexpr (std::is_same_v<T, float>) {
-                    parsed = std::strtof(candidate.c_str(), nullptr);
-                } else if constexpr (std::is_same_v<T, long double>) {
-                    parsed = std::strtold(candidate.c_str(), nullptr);
-                } else {
-                    parsed = std::strtod(candidate.c_str(), nullptr);
-                }
-
-                if (parsed == value) {
-                    return candidate;
+        char* format_float(T value, char* first) {
+            if constexpr (std::is_same_v<T, float> || std::is_same_v<T, double>) {
+                if (char* last = detail::format_shortest(value, first)) {
+                    return last;
                 }
             }
 
-            return out.str();
+            const std::string formatted = detail::format_float_probing(value);
+            std::memcpy(first, formatted.data(), formatted.size());
+            return first + formatted.size();
+        }
+
+        template <typename T>
+        std::string format_float(T value) {
+            char buffer[max_float_chars];
+            return std::string(buffer, format_float(value, buffer));
         }
 
     }
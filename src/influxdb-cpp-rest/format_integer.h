@@ -0,0 +1,91 @@
+/* * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+namespace influxdb {
+    namespace utility {
+
+        /// Upper bound on the characters written by format_integer(value, first)
+        constexpr std::size_t max_integer_chars = 20;
+
+        namespace detail {
+
+            inline constexpr char digit_pairs[] =
+                "00010203040506070809"
+                "10111213141516171819"
+                "20212223242526272829"
+                "30313233343536373839"
+                "40414243444546474849"
+                "50515253545556575859"
+                "60616263646566676869"
+                "70717273747576777879"
+                "80818283848586878889"
+                "90919293949596979899";
+
+            inline unsigned count_digits(std::uint64_t value) {
+                unsigned count = 1;
+                for (;;) {
+                    if (value < 10) return count;
+                    if (value < 100) return count + 1;
+                    if (value < 1000) return count + 2;
+                    if (value < 10000) return count + 3;
+                    value /= 10000;
+                    count += 4;
+                }
+            }
+
+            // writes the digits of value backwards, ending just before last
+            inline void write_digits(std::uint64_t value, char* last) {
+                while (value >= 100) {
+                    const auto pair = static_cast<std::size_t>(value % 100) * 2;
+                    value /= 100;
+                    *--last = digit_pairs[pair + 1];
+                    *--last = digit_pairs[pair];
+                }
+                if (value >= 10) {
+                    const auto pair = static_cast<std::size_t>(value) * 2;
+                    *--last = digit_pairs[pair + 1];
+                    *--last = digit_pairs[pair];
+                } else {
+                    *--last = static_cast<char>('0' + value);
+                }
+            }
+        }
+
+        // Formats an integer in decimal without streams, locales or
+        // allocations. Writes into [first, first + max_integer_chars) and
+        // returns the end of the output; no terminating zero is written.
+        template <typename T>
+        char* format_integer(T value, char* first) {
+            static_assert(std::is_integral_v<T> && !std::is_same_v<T, bool>, "integral value expected");
+            static_assert(sizeof(T) <= sizeof(std::uint64_t), "at most 64-bit integers are supported");
+
+            std::uint64_t magnitude = static_cast<std::uint64_t>(value);
+            if constexpr (std::is_signed_v<T>) {
+                if (value < 0) {
+                    *first++ = '-';
+                    magnitude = 0 - magnitude;
+                }
+            }
+
+            char* last = first + detail::count_digits(magnitude);
+            detail::write_digits(magnitude, last);
+            return last;
+        }
+
+        template <typename T>
+        void append_integer(std::string& out, T value) {
+            char buffer[max_integer_chars];
+            out.append(buffer, format_integer(value, buffer));
+        }
+
+    }
+}
@@ -0,0 +1,80 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+
+#include "gzip.h"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace {
+    // windowBits of 15 plus 16 selects the gzip header and trailer
+    constexpr int gzip_window_bits = 15 + 16;
+    constexpr int default_memory_level = 8;
+
+    // deflate's counters are uInt, so larger inputs are fed in slices
+    constexpr std::size_t max_slice = std::numeric_limits<uInt>::max();
+
+    struct deflate_stream {
+        z_stream stream{};
+
+        explicit deflate_stream(int level) {
+            if (deflateInit2(&stream, level, Z_DEFLATED, gzip_window_bits, default_memory_level, Z_DEFAULT_STRATEGY) != Z_OK)
+                throw std::runtime_error("gzip: could not initialize zlib");
+        }
+
+        ~deflate_stream() {
+            deflateEnd(&stream);
+        }
+    };
+}
+
+namespace influxdb {
+    namespace utility {
+
+        std::vector<unsigned char> gzip(std::string_view input, int level)
+        {
+            deflate_stream deflater(std::clamp(level, 1, 9));
+            z_stream& stream = deflater.stream;
+
+            // deflateBound covers the whole output, so that one pass suffices
+            std::vector<unsigned char> output(
+                deflateBound(&stream, static_cast<uLong>(std::min<std::size_t>(input.size(), std::numeric_limits<uLong>::max())))
+            );
+
+            auto next_in = reinterpret_cast<Bytef const*>(input.data());
+            std::size_t remaining = input.size();
+            int status = Z_OK;
+
+            while (status != Z_STREAM_END) {
+                auto const slice = std::min(remaining, max_slice);
+                stream.next_in = const_cast<Bytef*>(next_in);
+                stream.avail_in = static_cast<uInt>(slice);
+
+                if (stream.total_out == output.size())
+                    output.resize(output.size() * 2);
+                stream.next_out = output.data() + stream.total_out;
+                stream.avail_out = static_cast<uInt>(std::min(output.size() - stream.total_out, max_slice));
+
+                status = deflate(&stream, slice == remaining ? Z_FINISH : Z_NO_FLUSH);
+                if (status != Z_OK && status != Z_STREAM_END && status != Z_BUF_ERROR)
+                    throw std::runtime_error("gzip: compression failed: " + std::to_string(status));
+
+                auto const consumed = slice - stream.avail_in;
+                next_in += consumed;
+                remaining -= consumed;
+            }
+
+            output.resize(stream.total_out);
+            return output;
+        }
+    }
+}
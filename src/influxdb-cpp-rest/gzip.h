@@ -0,0 +1,20 @@
+/* * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include <string_view>
+#include <vector>
+
+namespace influxdb {
+    namespace utility {
+
+        /// Compresses input into a gzip stream (RFC 1952), as accepted by
+        /// InfluxDB's /write with "Content-Encoding: gzip". level ranges
+        /// from 1 (fastest) to 9 (smallest); out-of-range levels are clamped.
+        /// Throws std::runtime_error if zlib fails.
+        std::vector<unsigned char> gzip(std::string_view input, int level = 6);
+    }
+}
@@ -0,0 +1,176 @@
+/* * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "input_sanitizer.h"
+#include "influxdb_line.h"
+
+namespace influxdb {
+
+    namespace api {
+
+        /// Points of one series given as columns, i.e. one array per field
+        /// plus an optional timestamp array, all of the same length:
+        ///
+        ///     column_batch batch("cpu", key_value_pairs("host", "server01"));
+        ///     batch.add("usage", usage).add("cores", cores).timestamps(stamps);
+        ///     db.insert(line(batch.get()));
+        ///
+        /// The arrays are not copied and have to outlive the batch. Each row
+        /// is formatted exactly like line(measurement, tags, values, timestamp).
+        class column_batch {
+            struct column {
+                std::string prefix;  // "key=", preceded by ' ' or ','
+                void const* data;
+                void (*append)(std::string& res, void const* data, std::size_t row);
+            };
+
+            static constexpr std::size_t max_timestamp_chars = ::influxdb::utility::max_integer_chars;
+            static constexpr std::size_t max_value_chars = 24;
+
+            std::string series;
+            std::vector<column> columns;
+            std::size_t rows = 0;
+            void const* stamps = nullptr;
+            void (*append_stamp)(std::string& res, void const* data, std::size_t row) = nullptr;
+
+            template <typename T>
+            static void append_row(std::string& res, void const* data, std::size_t row) {
+                detail::append_value(res, static_cast<T const*>(data)[row]);
+            }
+
+            template <typename T>
+            static void append_stamp_row(std::string& res, void const* data, std::size_t row) {
+                ::influxdb::utility::append_integer(res, static_cast<T const*>(data)[row]);
+            }
+
+            void check_rows(std::size_t count) {
+                if (columns.empty() && stamps == nullptr) {
+                    rows = count;
+                } else if (count != rows) {
+                    throw std::runtime_error(
+                        "column length " + std::to_string(count) + " does not match the batch's " + std::to_string(rows) + " rows"
+                    );
+                }
+            }
+
+        public:
+            column_batch(std::string_view measurement, key_value_pairs const& tags) {
+                ::influxdb::utility::throw_on_invalid_identifier(measurement);
+
+                series = measurement;
+                if (!tags.empty()) {
+                    series.push_back(',');
+                    series += tags.view();
+                }
+            }
+
+            explicit column_batch(series_key const& series) :
+                series(series.get()) {
+            }
+
+            /// a field column: integers, bool, floating point or strings
+            template <typename T>
+            column_batch& add(std::string_view key, T const* values, std::size_t count) {
+                static_assert(
+                    std::is_arithmetic<T>::value || std::is_convertible<T const&, std::string_view>::value,
+                    "field columns hold integers, bool, floating point or strings"
+                );
+
+                ::influxdb::utility::throw_on_invalid_identifier(key);
+                check_rows(count);
+
+                std::string prefix(1, columns.empty() ? ' ' : ',');
+                prefix += key;
+                prefix.push_back('=');
+
+                columns.push_back(column{ std::move(prefix), values, &append_row<T> });
+                return *this;
+            }
+
+            /// a field column from a contiguous container, e.g. std::vector or std::span
+            template <typename TColumn>
+            column_batch& add(std::string_view key, TColumn const& values) {
+                static_assert(!std::is_convertible<TColumn const&, std::string_view>::value,
+                    "a single string is not a column; use key_value_pairs for single points");
+
+                return add(key, std::data(values), std::size(values));
+            }
+
+            /// integral timestamps, one per row
+            template <typename T>
+            column_batch& timestamps(T const* values, std::size_t count) {
+                static_assert(std::is_integral<T>::value && !std::is_same<bool, T>::value, "timestamps are integers");
+
+                check_rows(count);
+
+                stamps = values;
+                append_stamp = &append_stamp_row<T>;
+                return *this;
+            }
+
+            template <typename TColumn>
+            column_batch& timestamps(TColumn const& values) {
+                return timestamps(std::data(values), std::size(values));
+            }
+
+            inline std::size_t size() const {
+                return rows;
+            }
+
+            inline bool empty() const {
+                return rows == 0;
+            }
+
+            /// appends the rows as newline-separated lines
+            void append_to(std::string& res) const {
+                if (columns.empty())
+                    throw std::runtime_error("a column batch needs at least one field column");
+
+                if (rows == 0)
+                    return;
+
+                // rough upper bound for numeric columns, to avoid regrowing
+                std::size_t row_size = series.size() + 1 + (stamps ? 1 + max_timestamp_chars : 0);
+                for (auto const& c : columns)
+                    row_size += c.prefix.size() + max_value_chars;
+
+                if (!res.empty())
+                    res.push_back('\n');
+                res.reserve(res.size() + rows * row_size);
+
+                for (std::size_t row = 0; row < rows; ++row) {
+                    if (row)
+                        res.push_back('\n');
+
+                    res += series;
+                    for (auto const& c : columns) {
+                        res += c.prefix;
+                        c.append(res, c.data, row);
+                    }
+
+                    if (stamps) {
+                        res.push_back(' ');
+                        append_stamp(res, stamps, row);
+                    }
+                }
+            }
+
+            inline std::string get() const {
+                std::string res;
+                append_to(res);
+                return res;
+            }
+        };
+    }
+}
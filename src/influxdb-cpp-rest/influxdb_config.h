@@ -5,9 +5,39 @@
 
 #pragma once
 
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
 namespace influxdb {
     namespace api {
         
+        /// Lets the async API choose its batch size and interval from the
+        /// latency of its requests (additive increase, multiplicative
+        /// decrease). Each response within target_latency_ms grows the batch
+        /// by increase_lines; a slower one, or one refused for lack of a
+        /// server, scales it by decrease_factor. batch_config::max_lines
+        /// and max_time_ms become upper bounds, and the interval follows
+        /// the batch size between min_time_ms and max_time_ms.
+        struct adaptive_batch_config {
+            bool enabled = false;
+            
+            /// Latency to steer towards; 0 to grow batches until requests fail
+            unsigned target_latency_ms = 100;
+            
+            /// Lower bounds of the batch size and interval, also where it starts
+            unsigned min_lines = 100;
+            unsigned min_time_ms = 1;
+            
+            unsigned increase_lines = 500;
+            double decrease_factor = 0.5;
+            
+            adaptive_batch_config() = default;
+            adaptive_batch_config(bool enabled, unsigned target_latency_ms = 100)
+                : enabled(enabled), target_latency_ms(target_latency_ms) {}
+        };
+        
         /// Configuration for batching strategy in async API
         struct batch_config {
             /// Maximum number of lines to batch before sending
@@ -16,9 +46,137 @@ namespace influxdb {
             /// Maximum time in milliseconds to wait before sending a batch
             unsigned max_time_ms = 100;
             
+            /// Maximum size of a batch in bytes, 0 for no limit. Batches are
+            /// split between lines; a single longer line is sent on its own.
+            std::size_t max_bytes = 0;
+            
+            /// Off by default: batches use the limits above as they are
+            adaptive_batch_config adaptive;
+            
+            /// Reorder each batch by series, then timestamp, before sending
+            /// it, which InfluxDB ingests faster. Points that overwrite each
+            /// other keep their order.
+            bool sort_by_series = false;
+            
+            /// Merge the lines of a batch that write the same point, i.e.
+            /// the same series and timestamp, into one before sending it,
+            /// the later fields replacing the earlier ones as InfluxDB
+            /// would. Lines without a timestamp are not merged.
+            bool coalesce = false;
+            
             batch_config() = default;
-            batch_config(unsigned max_lines, unsigned max_time_ms) 
-                : max_lines(max_lines), max_time_ms(max_time_ms) {}
+            batch_config(unsigned max_lines, unsigned max_time_ms, std::size_t max_bytes = 0) 
+                : max_lines(max_lines), max_time_ms(max_time_ms), max_bytes(max_bytes) {}
+        };
+        
+        /// What async_api::simple_db::insert does when its queue is full
+        enum class overflow_policy {
+            /// wait until the queue has room
+            block,
+            /// discard the line being inserted
+            drop_newest,
+            /// discard the oldest queued line to make room
+            drop_oldest,
+            /// return false without queueing the line
+            fail
+        };
+        
+        /// Queues between async inserts and the batching threads
+        struct queue_config {
+            /// Maximum number of queued lines per worker, rounded up to a power
+            /// of two; 0 for twice batch_config::max_lines, within 1024..65536
+            std::size_t capacity = 0;
+            
+            overflow_policy overflow = overflow_policy::block;
+            
+            /// Number of workers, each with its own queue, batching thread and
+            /// connection. Lines are assigned to workers by series, so the
+            /// lines of one series are still sent in the order inserted.
+            unsigned workers = 1;
+            
+            /// On destruction, queued lines are sent for at most this long
+            /// and dropped after it, 0 for no limit. Requests already on the
+            /// wire are still waited for, see http_config::timeout_ms.
+            unsigned shutdown_timeout_ms = 0;
+            
+            queue_config() = default;
+            queue_config(std::size_t capacity, overflow_policy overflow = overflow_policy::block, unsigned workers = 1)
+                : capacity(capacity), overflow(overflow), workers(workers) {}
+        };
+        
+        /// Disk-backed queue for batches that could not be sent because the
+        /// server was unreachable or failed (no response or a 5xx status).
+        /// While it holds batches, new ones are appended behind them, and
+        /// they are sent again in order once the server answers. To keep
+        /// that order, a worker sends a batch only once the server answered
+        /// the previous one: http_config::max_in_flight does not apply.
+        /// The segment files are memory-mapped with POSIX mmap: on Windows,
+        /// an async simple_db with a directory set throws on construction.
+        struct spill_config {
+            /// Directory of the segment files, empty to disable spilling.
+            /// Each async worker uses a subdirectory of its own.
+            std::string directory;
+            
+            /// Size of a segment file; larger batches are not spilled
+            std::size_t segment_bytes = 16 * 1024 * 1024;
+            
+            /// Disk space per worker, batches beyond it are dropped
+            std::size_t max_bytes = 1024 * 1024 * 1024;
+            
+            /// Delay between attempts to send spilled batches while the server is down
+            unsigned retry_ms = 1000;
+            
+            spill_config() = default;
+            spill_config(std::string directory, std::size_t max_bytes = 1024 * 1024 * 1024)
+                : directory(std::move(directory)), max_bytes(max_bytes) {}
+        };
+        
+        /// Client-side downsampling in the async API. Lines of the chosen
+        /// measurements are not sent as they are: per series, the points
+        /// of each window of window_ms (by their timestamps) become one line
+        /// at the window's start with, for every field f, f_min, f_max,
+        /// f_mean, f_count and f_last; fields that are not numbers get only
+        /// f_last. A window is sent once a point of its series is stamped
+        /// grace_ms or more past its end, window_ms + grace_ms after its
+        /// first point arrived, or on flush() and destruction. Points of a
+        /// window that was sent already are late: they are sent as they
+        /// are, as a second line at the window's start would overwrite the
+        /// first. Chained lines inserted at once are sent as they are.
+        struct aggregate_config {
+            /// Length of a window in milliseconds, 0 to disable aggregation
+            unsigned window_ms = 0;
+            
+            /// How long past a window's end its points may still arrive out
+            /// of order, in timestamp milliseconds
+            unsigned grace_ms = 0;
+            
+            /// Series aggregated per async worker. Each keeps its key and
+            /// field statistics until the db is destroyed; lines of further
+            /// series are sent as they are.
+            std::size_t max_series = 100000;
+            
+            /// Measurements to aggregate, as formatted; empty for all
+            std::vector<std::string> measurements;
+            
+            aggregate_config() = default;
+            aggregate_config(unsigned window_ms, std::vector<std::string> measurements = {})
+                : window_ms(window_ms), measurements(std::move(measurements)) {}
+        };
+        
+        /// gzip compression of /write request bodies ("Content-Encoding: gzip")
+        struct compression_config {
+            /// Compress batches of at least min_bytes
+            bool enabled = false;
+            
+            /// Smaller bodies are sent as they are, as compressing them gains little
+            unsigned min_bytes = 1024;
+            
+            /// zlib level from 1 (fastest) to 9 (smallest)
+            int level = 6;
+            
+            compression_config() = default;
+            compression_config(bool enabled, unsigned min_bytes = 1024, int level = 6)
+                : enabled(enabled), min_bytes(min_bytes), level(level) {}
         };
         
         /// HTTP client configuration
@@ -32,6 +190,14 @@ namespace influxdb {
             /// Maximum connections per host
             unsigned max_connections_per_host = 10;
             
+            /// Maximum number of asynchronous inserts on the wire at once.
+            /// 1 sends batches strictly one after another; more lets batches
+            /// overlap their round trips, possibly completing out of order.
+            unsigned max_in_flight = 1;
+            
+            /// Compression of inserted lines (off by default)
+            compression_config compression;
+            
             http_config() = default;
             http_config(bool keepalive, unsigned timeout_ms = 0, unsigned max_connections_per_host = 10)
                 : keepalive(keepalive), timeout_ms(timeout_ms), max_connections_per_host(max_connections_per_host) {}
@@ -41,6 +207,9 @@ namespace influxdb {
         struct db_config {
             batch_config batch;
             http_config http;
+            queue_config queue;
+            spill_config spill;
+            aggregate_config aggregate;
             
             db_config() = default;
             db_config(const batch_config& batch, const http_config& http = http_config())
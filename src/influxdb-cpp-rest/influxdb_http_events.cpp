@@ -0,0 +1,85 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+
+#include "influxdb_http_events.h"
+
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+namespace {
+    // response bodies make for many distinct messages; past this many they are not kept
+    constexpr std::size_t max_interned = 512;
+
+    struct error_table {
+        std::mutex mutex;
+        // a deque keeps the strings where they are, the map's keys view them
+        std::deque<std::string> messages{ "", "(error message not kept)" };
+        std::unordered_map<std::string_view, std::uint32_t> codes;
+    };
+
+    error_table& errors() {
+        static error_table table;
+        return table;
+    }
+}
+
+influxdb::api::http_operation influxdb::api::http_operation_of(std::string_view operation)
+{
+    if (operation == "insert")
+        return http_operation::insert;
+    if (operation == "query")
+        return http_operation::query;
+    if (operation == "create")
+        return http_operation::create;
+    if (operation == "drop")
+        return http_operation::drop;
+    return http_operation::other;
+}
+
+std::uint32_t influxdb::api::intern_http_error(std::string_view message)
+{
+    if (message.empty())
+        return http_error_none;
+
+    auto& table = errors();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    auto const found = table.codes.find(message);
+    if (found != table.codes.end())
+        return found->second;
+
+    if (table.messages.size() >= max_interned)
+        return http_error_not_kept;
+
+    auto const code = static_cast<std::uint32_t>(table.messages.size());
+    table.messages.emplace_back(message);
+    table.codes.emplace(table.messages.back(), code);
+    return code;
+}
+
+std::string_view influxdb::api::http_error_message(std::uint32_t error)
+{
+    auto& table = errors();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    return error < table.messages.size() ? std::string_view(table.messages[error]) : std::string_view("");
+}
+
+influxdb::api::http_event influxdb::api::http_event::from(http_result const& result)
+{
+    http_event event;
+    event.timestamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(result.timestamp.time_since_epoch()).count();
+    event.bytes_sent = result.bytes_sent;
+    event.bytes_on_wire = result.bytes_on_wire;
+    event.bytes_received = result.bytes_received;
+    event.duration_us = static_cast<std::uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(result.duration_ms).count());
+    event.error = result.success ? http_error_none : intern_http_error(result.error_message);
+    event.status_code = static_cast<std::uint16_t>(result.status_code);
+    event.operation = http_operation_of(result.operation);
+    event.success = result.success;
+    return event;
+}
@@ -6,8 +6,11 @@
 #pragma once
 
 #include <chrono>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <memory>
+#include <type_traits>
 
 namespace influxdb {
     namespace api {
@@ -18,6 +21,7 @@ namespace influxdb {
             std::chrono::steady_clock::time_point timestamp;
             std::string operation;      // "insert", "query", etc.
             size_t bytes_sent;         // Number of bytes in request
+            size_t bytes_on_wire;       // Number of request body bytes transmitted (less than bytes_sent if compressed)
             size_t bytes_received;      // Number of bytes in response (0 if failed)
             unsigned status_code;       // HTTP status code (0 if error occurred)
             std::string error_message;  // Error message (empty if success)
@@ -25,9 +29,51 @@ namespace influxdb {
             
             http_result(bool success, std::string op, size_t bytes_sent = 0)
                 : success(success), timestamp(std::chrono::steady_clock::now()),
-                  operation(std::move(op)), bytes_sent(bytes_sent), 
+                  operation(std::move(op)), bytes_sent(bytes_sent), bytes_on_wire(bytes_sent),
                   bytes_received(0), status_code(0), duration_ms(0) {}
         };
+
+        enum class http_operation : std::uint8_t {
+            insert,
+            query,
+            create,
+            drop,
+            other
+        };
+
+        http_operation http_operation_of(std::string_view operation);
+
+        /// Error messages are interned: an http_event carries a number that
+        /// http_error_message() turns back into the text. 0 stands for no
+        /// error. The table keeps the first few hundred distinct messages;
+        /// later ones share http_error_not_kept.
+        constexpr std::uint32_t http_error_none = 0;
+        constexpr std::uint32_t http_error_not_kept = 1;
+
+        std::uint32_t intern_http_error(std::string_view message);
+        std::string_view http_error_message(std::uint32_t error);
+
+        /// The outcome of an HTTP request as plain data: cheap to copy,
+        /// with no allocation to build one. See async_api::simple_db::on_http_event().
+        struct http_event {
+            /// steady_clock time of the response, in nanoseconds since the clock's epoch
+            std::int64_t timestamp_ns;
+            std::uint64_t bytes_sent;
+            std::uint64_t bytes_on_wire;
+            std::uint64_t bytes_received;
+            std::uint32_t duration_us;
+            /// see http_error_message()
+            std::uint32_t error;
+            /// 0 if no response arrived
+            std::uint16_t status_code;
+            http_operation operation;
+            bool success;
+
+            /// interns result's error message, if any
+            static http_event from(http_result const& result);
+        };
+
+        static_assert(std::is_trivially_copyable_v<http_event>, "http_event is copied across threads and to C");
         
     }
 }
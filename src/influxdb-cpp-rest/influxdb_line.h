@@ -5,18 +5,114 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cstddef>
+#include <memory>
 #include <string>
 #include <utility>
 #include <chrono>
 #include <type_traits>
 #include <sstream>
+#include <string_view>
 #include "input_sanitizer.h"
 #include "format_float.h"
+#include "format_integer.h"
 
 namespace influxdb {
 
     namespace api {
 
+        namespace detail {
+
+            // Strings leaving the small string buffer start with at least this
+            // capacity, enough for a few pairs or a short line
+            constexpr std::size_t min_heap_chars = 64;
+
+            // Makes room for extra more characters, keeping the growth
+            // geometric even where std::string::reserve grows exactly
+            inline void reserve_more(std::string& res, std::size_t extra) {
+                if (res.capacity() - res.size() < extra) {
+                    res.reserve(std::max({ res.size() + extra, 2 * res.capacity(), min_heap_chars }));
+                }
+            }
+
+            // Line protocol value formatting shared by key_value_pairs and
+            // the compile-time schemas in influxdb_schema.h. Numbers are
+            // formatted into a caller's buffer first, so that their length
+            // is known before the output string is grown.
+
+            constexpr std::size_t value_buffer_chars = ::influxdb::utility::max_float_chars;
+
+            template<
+                class V,
+                typename std::enable_if<
+                    std::is_integral<V>::value &&
+                    (! std::is_same<bool, V>::value)
+                >::type* = nullptr
+            >
+            inline std::string_view format_value(char* buffer, V const& value) {
+                char* last = ::influxdb::utility::format_integer(value, buffer);
+                *last++ = 'i';
+                return std::string_view(buffer, last - buffer);
+            }
+
+            template<
+                class V,
+                typename std::enable_if<
+                    std::is_integral<V>::value &&
+                    ( std::is_same<bool, V>::value)
+                >::type* = nullptr
+            >
+            inline std::string_view format_value(char*, V const& value) {
+                return value ? std::string_view("true") : std::string_view("false");
+            }
+
+            template<
+                class V,
+                typename std::enable_if<
+                std::is_floating_point<V>::value
+                >::type* = nullptr
+            >
+            inline std::string_view format_value(char* buffer, V const& value) {
+                return std::string_view(buffer, ::influxdb::utility::format_float(value, buffer) - buffer);
+            }
+
+            template<
+                class V,
+                typename std::enable_if<
+                std::is_arithmetic<V>::value
+                >::type* = nullptr
+            >
+            inline void append_value(std::string& res, V const& value) {
+                char buffer[value_buffer_chars];
+                res += format_value(buffer, value);
+            }
+
+            inline void append_value(std::string& res, std::string_view value) {
+                res.push_back('"');
+                res += value;
+                res.push_back('"');
+            }
+
+            // integral timestamps (e.g. default_timestamp) are written without
+            // a stream; string-like ones are appended as they are
+            template<typename TTimestamp>
+            inline void append_timestamp(std::string& res, TTimestamp const& timestamp) {
+                auto const stamp = timestamp.now();
+                using stamp_type = std::decay_t<decltype(stamp)>;
+
+                if constexpr (std::is_integral<stamp_type>::value) {
+                    ::influxdb::utility::append_integer(res, stamp);
+                } else if constexpr (std::is_convertible<stamp_type const&, std::string_view>::value) {
+                    res += std::string_view(stamp);
+                } else {
+                    std::ostringstream out;
+                    out << stamp;
+                    res += out.str();
+                }
+            }
+        }
+
         // https://docs.influxdata.com/influxdb/v1.0/write_protocols/line_protocol_tutorial/
         class key_value_pairs {
             std::string res;
@@ -41,94 +137,96 @@ namespace influxdb {
             }
 
             template<typename V>
-            key_value_pairs(std::string const& key, V const& value) {
+            key_value_pairs(std::string_view key, V const& value) {
                 add(key, value);
             }
 
             template<
                 class V,
                 typename std::enable_if<
-                    std::is_integral<V>::value &&
-                    (! std::is_same<bool, V>::value)
+                std::is_arithmetic<V>::value
                 >::type* = nullptr
             >
-                key_value_pairs& add(std::string const& key, V const& value) {
+                key_value_pairs& add(std::string_view key, V const& value) {
                 ::influxdb::utility::throw_on_invalid_identifier(key);
 
-                add_comma_if_necessary();
-
-                std::ostringstream out;
-                out << key << '=' << value << 'i';
-                res += out.str();
-
-                return *this;
-            }
-
-            template<
-                class V,
-                typename std::enable_if<
-                    std::is_integral<V>::value &&
-                    ( std::is_same<bool, V>::value)
-                >::type* = nullptr
-            >
-                key_value_pairs& add(std::string const& key, V const& value) {
-                ::influxdb::utility::throw_on_invalid_identifier(key);
+                char buffer[detail::value_buffer_chars];
+                auto const text = detail::format_value(buffer, value);
 
-                add_comma_if_necessary();
+                start_pair(key.size() + text.size());
 
                 res += key;
                 res.push_back('=');
-                res += (value ? "true" : "false");
+                res += text;
 
                 return *this;
             }
 
-            template<
-                class V,
-                typename std::enable_if<
-                std::is_floating_point<V>::value
-                >::type* = nullptr
-            >
-                key_value_pairs& add(std::string const& key, V const& value) {
+            key_value_pairs& add(std::string_view key, std::string_view value) {
                 ::influxdb::utility::throw_on_invalid_identifier(key);
 
-                add_comma_if_necessary();
+                start_pair(key.size() + value.size() + 2);
 
                 res += key;
                 res.push_back('=');
-                res += ::influxdb::utility::format_float(value);
+                detail::append_value(res, value);
 
                 return *this;
             }
 
-            key_value_pairs& add(std::string const& key, std::string const& value) {
-                ::influxdb::utility::throw_on_invalid_identifier(key);
-
-                add_comma_if_necessary();
-
-                res += key;
-                res += "=\"";
-                res += value;
-                res.push_back('"');
-
-                return *this;
+            inline std::string get() const {
+                return res;
             }
 
-            inline std::string get() const {
+            /// the formatted pairs, valid until the next modification
+            inline std::string_view view() const {
                 return res;
             }
 
+            /// moves the formatted pairs out, leaving this empty
+            inline std::string take() {
+                std::string out;
+                out.swap(res);
+                return out;
+            }
+
             inline bool empty() const {
                 return res.empty();
             }
 
         private:
-            inline void add_comma_if_necessary() {
+            // room for the pair and its '=', preceded by a comma if necessary
+            inline void start_pair(std::size_t size) {
+                detail::reserve_more(res, size + 2);
+
                 if (!this->empty())
                     res.push_back(',');
             }
         };
 
+        /// Preformatted "measurement,tag=value,..." prefix of a line, shared
+        /// between all lines of the same series. Obtained from a series_cache
+        /// (influxdb_series_cache.h); stays valid after being evicted from it.
+        class series_key {
+            std::shared_ptr<std::string const> key;
+
+        public:
+            series_key() {};
+
+            explicit series_key(std::shared_ptr<std::string const> key)
+                : key(std::move(key)) {
+            }
+
+            inline std::string const& get() const {
+                static const std::string none;
+                return key ? *key : none;
+            }
+
+            inline bool empty() const {
+                return !key || key->empty();
+            }
+        };
+
         /// https://docs.influxdata.com/influxdb/v1.2/write_protocols/line_protocol_tutorial/#timestamp
         struct default_timestamp {
             inline size_t now() const {
@@ -140,6 +238,9 @@ namespace influxdb {
 
         /// simplest, probably slow implementation
         class line {
+            // separators, a timestamp and the '\n' of a following line
+            static constexpr std::size_t line_extra_chars = 4 + ::influxdb::utility::max_integer_chars;
+
             std::string res;
 
         public:
@@ -163,54 +264,124 @@ namespace influxdb {
                 res = raw;
             }
 
+            explicit line(std::string&& raw) {
+                res = std::move(raw);
+            }
+
             template<typename TTimestamp>
             explicit line(std::string const& raw, TTimestamp const& timestamp) {
-                std::ostringstream out;
-                out << raw << ' ' << timestamp.now();
-                res = out.str();
+                res = raw;
+                res.push_back(' ');
+                detail::append_timestamp(res, timestamp);
             }
 
             template<typename TMap>
-            inline line(std::string const& measurement, TMap const& tags, TMap const& values) {
-                ::influxdb::utility::throw_on_invalid_identifier(measurement);
+            inline line(std::string_view measurement, TMap const& tags, TMap const& values) {
+                append(measurement, tags, values);
+            }
 
-                res += measurement;
-                if (!tags.empty()) {
-                    res.push_back(',');
-                    res += tags.get();
-                }
+            template<typename TMap,typename TTimestamp>
+            inline line(std::string_view measurement, TMap const& tags, TMap const& values, TTimestamp const& timestamp) {
+                append(measurement, tags, values);
+                res.push_back(' ');
+                detail::append_timestamp(res, timestamp);
+            }
 
-                if (!values.empty()) {
-                    res.push_back(' ');
-                    res += values.get();
-                }
+            template<typename TMap>
+            inline line(series_key const& series, TMap const& values) {
+                append(series, values);
             }
 
-            template<typename TMap,typename TTimestamp>
-            inline line(std::string const& measurement, TMap const& tags, TMap const& values, TTimestamp const& timestamp):
-            line(measurement, tags, values) {
-                std::ostringstream out;
-                out << ' ' << timestamp.now();
-                res += out.str();
+            template<typename TMap, typename TTimestamp>
+            inline line(series_key const& series, TMap const& values, TTimestamp const& timestamp) {
+                append(series, values);
+                res.push_back(' ');
+                detail::append_timestamp(res, timestamp);
+            }
+
+            // the chained lines are formatted in place, at the end of this one
+
+            template<typename TMap>
+            inline line& operator()(std::string_view measurement, TMap const& tags, TMap const& values) {
+                res.push_back('\n');
+                append(measurement, tags, values);
+                return *this;
+            }
+
+            template<typename TMap, typename TTimestamp>
+            inline line& operator()(std::string_view measurement, TMap const& tags, TMap const& values, TTimestamp const& timestamp) {
+                res.push_back('\n');
+                append(measurement, tags, values);
+                res.push_back(' ');
+                detail::append_timestamp(res, timestamp);
+                return *this;
             }
 
             template<typename TMap>
-            inline line& operator()(std::string const& measurement, TMap const& tags, TMap const& values) {
+            inline line& operator()(series_key const& series, TMap const& values) {
                 res.push_back('\n');
-                res += line(measurement, tags, values).get();
+                append(series, values);
                 return *this;
             }
 
             template<typename TMap, typename TTimestamp>
-            inline line& operator()(std::string const& measurement, TMap const& tags, TMap const& values, TTimestamp const& timestamp) {
+            inline line& operator()(series_key const& series, TMap const& values, TTimestamp const& timestamp) {
                 res.push_back('\n');
-                res += line(measurement, tags, values, timestamp).get();
+                append(series, values);
+                res.push_back(' ');
+                detail::append_timestamp(res, timestamp);
                 return *this;
             }
+
+        private:
+            template<typename TMap>
+            inline void append(std::string_view measurement, TMap const& tags, TMap const& values) {
+                ::influxdb::utility::throw_on_invalid_identifier(measurement);
+
+                detail::reserve_more(res, measurement.size() + tags.view().size() + values.view().size() + line_extra_chars);
+
+                res += measurement;
+                if (!tags.empty()) {
+                    res.push_back(',');
+                    res += tags.view();
+                }
+
+                append_values(values);
+            }
+
+            template<typename TMap>
+            inline void append(series_key const& series, TMap const& values) {
+                detail::reserve_more(res, series.get().size() + values.view().size() + line_extra_chars);
+
+                res += series.get();
+                append_values(values);
+            }
+
+            template<typename TMap>
+            inline void append_values(TMap const& values) {
+                if (!values.empty()) {
+                    res.push_back(' ');
+                    res += values.view();
+                }
+            }
+
         public:
             inline std::string get() const {
                 return res;
             }
+
+            /// the formatted line(s), valid until the next modification
+            inline std::string_view view() const {
+                return res;
+            }
+
+            /// moves the formatted line(s) out, leaving this line empty,
+            /// e.g. to hand them over to a request body without a copy
+            inline std::string take() {
+                std::string out;
+                out.swap(res);
+                return out;
+            }
         };
 
     }
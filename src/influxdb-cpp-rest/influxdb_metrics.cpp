@@ -0,0 +1,96 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+
+#include "influxdb_metrics.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+using influxdb::api::histogram;
+using influxdb::api::histogram_snapshot;
+
+histogram::histogram() :
+    sum(0),
+    largest(0)
+{
+    for (auto& count : counts)
+        count.store(0, std::memory_order_relaxed);
+}
+
+// Values below sub_buckets have a bucket each; above, every power of two
+// [2^e, 2^(e+1)) is split into sub_buckets buckets of width 2^(e - sub_bucket_bits)
+std::size_t histogram::bucket_of(std::uint64_t value)
+{
+    if (value < sub_buckets)
+        return static_cast<std::size_t>(value);
+
+    unsigned const shift = static_cast<unsigned>(std::bit_width(value)) - 1 - sub_bucket_bits;
+    return sub_buckets + shift * sub_buckets + static_cast<std::size_t>((value >> shift) - sub_buckets);
+}
+
+std::uint64_t histogram::lowest_in(std::size_t bucket)
+{
+    if (bucket < sub_buckets)
+        return bucket;
+
+    auto const shift = (bucket - sub_buckets) / sub_buckets;
+    auto const sub = (bucket - sub_buckets) % sub_buckets;
+    return static_cast<std::uint64_t>(sub_buckets + sub) << shift;
+}
+
+std::uint64_t histogram::highest_in(std::size_t bucket)
+{
+    if (bucket < sub_buckets)
+        return bucket;
+
+    auto const shift = (bucket - sub_buckets) / sub_buckets;
+    return lowest_in(bucket) + ((std::uint64_t(1) << shift) - 1);
+}
+
+void histogram::record(std::uint64_t value)
+{
+    counts[bucket_of(value)].fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(value, std::memory_order_relaxed);
+
+    auto seen = largest.load(std::memory_order_relaxed);
+    while (value > seen && !largest.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {
+    }
+}
+
+histogram_snapshot histogram::snapshot() const
+{
+    // the buckets are read one by one while others may record: a snapshot
+    // is consistent per counter, and the total is taken from the buckets
+    histogram_snapshot result;
+    result.counts.resize(bucket_count);
+    for (std::size_t i = 0; i < bucket_count; ++i) {
+        result.counts[i] = counts[i].load(std::memory_order_relaxed);
+        result.total += result.counts[i];
+    }
+    result.sum = sum.load(std::memory_order_relaxed);
+    result.largest = largest.load(std::memory_order_relaxed);
+    return result;
+}
+
+std::uint64_t histogram_snapshot::percentile(double fraction) const
+{
+    if (total == 0)
+        return 0;
+
+    auto const rank = std::clamp<std::uint64_t>(
+        static_cast<std::uint64_t>(std::ceil(std::clamp(fraction, 0.0, 1.0) * static_cast<double>(total))), 1, total);
+
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < counts.size(); ++i) {
+        seen += counts[i];
+        if (seen >= rank)
+            return std::min(histogram::highest_in(i), largest);
+    }
+    return largest;
+}
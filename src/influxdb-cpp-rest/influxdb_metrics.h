@@ -0,0 +1,105 @@
+/* * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace influxdb {
+    namespace api {
+
+        /// A copy of a histogram's buckets, see histogram::snapshot()
+        class histogram_snapshot {
+            std::vector<std::uint64_t> counts;
+            std::uint64_t total = 0;
+            std::uint64_t sum = 0;
+            std::uint64_t largest = 0;
+
+            friend class histogram;
+
+        public:
+            std::uint64_t count() const { return total; }
+            std::uint64_t max() const { return largest; }
+            double mean() const { return total == 0 ? 0.0 : static_cast<double>(sum) / total; }
+
+            /// the value below which fraction (0..1) of the recorded values
+            /// fall, within the histogram's precision; 0 if it is empty
+            std::uint64_t percentile(double fraction) const;
+        };
+
+        /// Counts non-negative integers in log-linear buckets, as HDR
+        /// histograms do: 16 buckets per power of two, so that a
+        /// percentile is off by at most 1/16 of its value. Recording is a
+        /// few relaxed atomic increments and never blocks.
+        class histogram {
+        public:
+            static constexpr unsigned sub_bucket_bits = 4;
+            static constexpr std::size_t sub_buckets = std::size_t(1) << sub_bucket_bits;
+            static constexpr std::size_t bucket_count = sub_buckets + (64 - sub_bucket_bits) * sub_buckets;
+
+            histogram();
+            histogram(histogram const&) = delete;
+            histogram& operator=(histogram const&) = delete;
+
+            void record(std::uint64_t value);
+
+            histogram_snapshot snapshot() const;
+
+            /// the bucket of value, and the smallest and largest value in a bucket
+            static std::size_t bucket_of(std::uint64_t value);
+            static std::uint64_t lowest_in(std::size_t bucket);
+            static std::uint64_t highest_in(std::size_t bucket);
+
+        private:
+            std::array<std::atomic<std::uint64_t>, bucket_count> counts;
+            std::atomic<std::uint64_t> sum;
+            std::atomic<std::uint64_t> largest;
+        };
+
+        /// A snapshot of the async API's pipeline, see
+        /// async_api::simple_db::metrics(). Lines are counted per insert:
+        /// chained lines inserted at once count as one, unless they are
+        /// queued one by one for different workers or for max_bytes.
+        struct async_metrics {
+            /// taken by insert() or try_insert(); not the ones try_insert()
+            /// leaves with the caller
+            std::uint64_t lines_enqueued = 0;
+            /// acknowledged by the server, including replayed ones
+            std::uint64_t lines_sent = 0;
+            /// refused by the server or never answered, including spilled
+            /// lines the server refused for their content on replay
+            std::uint64_t lines_failed = 0;
+            /// written to the spill queue instead, see db_config::spill
+            std::uint64_t lines_spilled = 0;
+            /// lost to overflow or the shutdown deadline, see simple_db::dropped()
+            std::uint64_t lines_dropped = 0;
+            /// merged into another line of their batch, see
+            /// batch_config::coalesce; they count as sent, failed or
+            /// spilled with it as well
+            std::uint64_t lines_coalesced = 0;
+            /// replaced by the aggregates of db_config::aggregate, which
+            /// count them as sent, failed or spilled
+            std::uint64_t lines_aggregated = 0;
+
+            std::size_t queue_depth = 0;
+            std::size_t queue_capacity = 0;
+
+            /// the batch limits in effect, which change with
+            /// batch_config::adaptive
+            unsigned batch_max_lines = 0;
+            unsigned batch_max_time_ms = 0;
+
+            /// batches sent, and their size in lines and in bytes
+            histogram_snapshot batch_lines;
+            histogram_snapshot batch_bytes;
+            /// time from handing a batch to the HTTP client to its response, in microseconds
+            histogram_snapshot latency_us;
+        };
+    }
+}
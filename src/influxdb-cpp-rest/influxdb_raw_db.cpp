@@ -11,6 +11,12 @@
 #include <cpprest/streams.h>
 #include <cpprest/http_client.h>
 
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+
 using namespace utility;
 using namespace web;
 using namespace web::http;
@@ -24,67 +30,65 @@ namespace {
 #endif
     }
 
-    inline http_request request_from(
-            uri const& uri_with_db,
-            std::string const& lines,
-            std::string const& username,
-            std::string const& password,
-            web::http::method const& m = methods::POST
-    ) {
-        http_request request;
-
-        request.set_request_uri(uri_with_db);
-        request.set_method(m);
-
-        if (!username.empty()) {
-            auto auth = username + ":" + password;
-            std::vector<unsigned char> bytes(auth.begin(), auth.end());
-            request
-                .headers()
-                .add(
-                    header_names::authorization,
-                    U("Basic ") +
-                    conversions::to_base64(bytes)
-                )
-            ;
-        }
+    inline std::runtime_error response_error(string_t const& body) {
+#ifndef _MSC_VER
+        return std::runtime_error(body);
+#else
+        return std::runtime_error(conversions::utf16_to_utf8(body));
+#endif
+    }
+}
+
+// Bounds the number of insert_async requests on the wire. Shared with
+// the request continuations, so that it outlives a destroyed db.
+struct influxdb::raw::db::in_flight_window {
+    std::mutex mutex;
+    std::condition_variable changed;
+    unsigned count = 0;
+    unsigned max = 1;
+
+    void acquire() {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [this] { return count < max; });
+        ++count;
+    }
 
-        request.set_body(lines);
+    void release() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            --count;
+        }
+        changed.notify_all();
+    }
 
-        return request;
+    void wait_idle() {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [this] { return count == 0; });
     }
-}
+};
 
 influxdb::raw::db::db(string_t const & url, string_t const & name)
     :
-    client(url)
+    client(url),
+    writes(write_template(client.base_uri(), name, string_t())),
+    queries(query_template(string_t())),
+    in_flight(std::make_shared<in_flight_window>())
 {
-    uri_builder builder(client.base_uri());
-    builder.append(U("/write"));
-    builder.append_query(U("db"), name);
-    uri_with_db = builder.to_uri();
 }
 
 influxdb::raw::db::db(string_t const & url, string_t const & name, http_client_config const& config)
     :
-    client(url, config)
+    client(url, config),
+    writes(write_template(client.base_uri(), name, string_t())),
+    queries(query_template(string_t())),
+    in_flight(std::make_shared<in_flight_window>())
 {
-    uri_builder builder(client.base_uri());
-    builder.append(U("/write"));
-    builder.append_query(U("db"), name);
-    uri_with_db = builder.to_uri();
 }
 
 void influxdb::raw::db::post(string_t const & query)
 {
-    uri_builder builder(U("/query"));
-
-    builder.append_query(U("q"), query);
-
     // synchronous for now
-    auto response = client.request(
-        request_from(builder.to_string(), "", username, password)
-    );
+    auto response = client.request(queries.query(query));
 
     try {
         response.wait();
@@ -98,14 +102,8 @@ void influxdb::raw::db::post(string_t const & query)
 
 string_t influxdb::raw::db::get(string_t const & query)
 {
-    uri_builder builder(U("/query"));
-
-    builder.append_query(U("q"), query);
-
     // synchronous for now
-    auto response = client.request(
-        request_from(builder.to_string(), "", username, password)
-    );
+    auto response = client.request(queries.query(query));
 
     try {
         response.wait();
@@ -123,9 +121,9 @@ string_t influxdb::raw::db::get(string_t const & query)
     }
 }
 
-void influxdb::raw::db::insert(std::string const & lines)
+void influxdb::raw::db::insert(std::string lines)
 {
-    auto response = client.request(request_from(uri_with_db, lines, username, password));
+    auto response = client.request(writes.insert(std::move(lines), compression));
 
     try {
         response.wait();
@@ -137,14 +135,103 @@ void influxdb::raw::db::insert(std::string const & lines)
     }
 }
 
-// synchronous for now
-void influxdb::raw::db::insert_async(std::string const & lines)
+pplx::task<void> influxdb::raw::db::insert_async(
+    std::string lines,
+    std::function<void(influxdb::api::http_result const&)> on_complete)
+{
+    auto window = in_flight;
+    window->acquire();
+
+    auto const bytes_sent = lines.size();
+    auto const start = std::chrono::steady_clock::now();
+    auto status = std::make_shared<unsigned>(0);
+
+    auto bytes_on_wire = bytes_sent;
+
+    pplx::task<http_response> response;
+    try {
+        auto request = writes.insert(std::move(lines), compression);
+        bytes_on_wire = static_cast<std::size_t>(request.headers().content_length());
+        response = client.request(request);
+    } catch (...) {
+        response = pplx::task_from_exception<http_response>(std::current_exception());
+    }
+
+    return response
+        .then([status](http_response response) {
+            *status = response.status_code();
+            if (*status == status_codes::OK || *status == status_codes::NoContent) {
+                return pplx::task_from_result();
+            }
+
+            return response.extract_string().then([](string_t body) {
+                throw response_error(body);
+            });
+        })
+        .then([window, on_complete, bytes_sent, bytes_on_wire, start, status](pplx::task<void> outcome) {
+            influxdb::api::http_result result(true, "insert", bytes_sent);
+            result.bytes_on_wire = bytes_on_wire;
+            std::exception_ptr error;
+
+            try {
+                outcome.get();
+            } catch (std::exception const& e) {
+                result.success = false;
+                result.error_message = e.what();
+                error = std::current_exception();
+            }
+
+            result.status_code = *status;
+            result.duration_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start
+            );
+
+            if (on_complete) {
+                try {
+                    on_complete(result);
+                } catch (...) {
+                    // the callback must not keep the request in the window
+                }
+            }
+
+            window->release();
+
+            // with a callback, the outcome has been reported and the task
+            // is typically not observed, so it must not fault
+            if (error && !on_complete) {
+                std::rethrow_exception(error);
+            }
+        });
+}
+
+void influxdb::raw::db::wait_for_in_flight()
+{
+    in_flight->wait_idle();
+}
+
+void influxdb::raw::db::set_compression(influxdb::api::compression_config const& compression)
+{
+    this->compression = compression;
+}
+
+void influxdb::raw::db::set_max_in_flight(unsigned max_in_flight)
+{
+    {
+        std::lock_guard<std::mutex> lock(in_flight->mutex);
+        in_flight->max = std::max(max_in_flight, 1u);
+    }
+    in_flight->changed.notify_all();
+}
+
+unsigned influxdb::raw::db::max_in_flight() const
 {
-    insert(lines);
+    std::lock_guard<std::mutex> lock(in_flight->mutex);
+    return in_flight->max;
 }
 
 void influxdb::raw::db::with_authentication(std::string const& username, std::string const& password)
 {
-    this->username = username;
-    this->password = password;
+    auto const authorization = basic_authorization(username, password);
+    writes.authorization = authorization;
+    queries.authorization = authorization;
 }
@@ -6,8 +6,12 @@
 #pragma once
 
 #include <cpprest/http_client.h>
+#include <functional>
 #include <string>
 #include <memory>
+#include "influxdb_config.h"
+#include "influxdb_http_events.h"
+#include "influxdb_raw_request.h"
 
 using utility::string_t;
 using web::http::client::http_client;
@@ -18,10 +22,14 @@ namespace influxdb {
     namespace raw {
         class db {
             http_client client;
-            uri uri_with_db;
 
-            std::string username;
-            std::string password;
+            request_template writes;
+            request_template queries;
+
+            influxdb::api::compression_config compression;
+
+            struct in_flight_window;
+            std::shared_ptr<in_flight_window> in_flight;
 
         public:
             db(string_t const& url, string_t const& name);
@@ -33,11 +41,28 @@ namespace influxdb {
             /// read queries
             string_t get(string_t const& query);
 
-            /// post measurements
-            void insert(std::string const& lines);
+            /// post measurements; the lines are moved into the request body
+            void insert(std::string lines);
+
+            /// post measurements and do not wait for the response.
+            /// At most max_in_flight() requests are on the wire at once; when
+            /// the window is full, this blocks until a request completes.
+            /// on_complete is called with the outcome before the request
+            /// leaves the window; failures also fault the returned task.
+            pplx::task<void> insert_async(
+                std::string lines,
+                std::function<void(influxdb::api::http_result const&)> on_complete = {}
+            );
+
+            /// blocks until no insert_async request is on the wire
+            void wait_for_in_flight();
+
+            /// gzip the bodies of insert and insert_async requests
+            void set_compression(influxdb::api::compression_config const& compression);
 
-            /// post measurements and do not wait
-            void insert_async(std::string const& lines);
+            /// maximum number of concurrent insert_async requests (at least 1)
+            void set_max_in_flight(unsigned max_in_flight);
+            unsigned max_in_flight() const;
 
             /// set username & password for basic authentication
             void with_authentication(std::string const& username, std::string const& password);
@@ -52,7 +52,10 @@ public:
 #else
         db_utf16(conversions::utf8_to_utf16(url), conversions::utf8_to_utf16(name), make_http_client_config(config))
 #endif
-    {}
+    {
+        db_utf16.set_max_in_flight(config.max_in_flight);
+        db_utf16.set_compression(config.compression);
+    }
 };
 
 influxdb::raw::db_utf8::db_utf8(std::string const & url, std::string const& name) :
@@ -89,13 +92,35 @@ std::string influxdb::raw::db_utf8::get(std::string const& query) {
 #endif
 }
 
-void influxdb::raw::db_utf8::insert(std::string const & lines) {
-    pimpl->db_utf16.insert(lines);
+void influxdb::raw::db_utf8::insert(std::string lines) {
+    pimpl->db_utf16.insert(std::move(lines));
+}
+
+std::future<void> influxdb::raw::db_utf8::insert_async(std::string lines)
+{
+    auto done = std::make_shared<std::promise<void>>();
+    auto result = done->get_future();
+
+    pimpl->db_utf16.insert_async(std::move(lines)).then([done](pplx::task<void> outcome) {
+        try {
+            outcome.get();
+            done->set_value();
+        } catch (...) {
+            done->set_exception(std::current_exception());
+        }
+    });
+
+    return result;
+}
+
+void influxdb::raw::db_utf8::insert_async(std::string lines, std::function<void(influxdb::api::http_result const&)> on_complete)
+{
+    pimpl->db_utf16.insert_async(std::move(lines), std::move(on_complete));
 }
 
-void influxdb::raw::db_utf8::insert_async(std::string const & lines)
+void influxdb::raw::db_utf8::wait_for_in_flight()
 {
-    pimpl->db_utf16.insert_async(lines);
+    pimpl->db_utf16.wait_for_in_flight();
 }
 
 void influxdb::raw::db_utf8::with_authentication(std::string const& username, std::string const& password)
@@ -5,9 +5,12 @@
 
 #pragma once
 
+#include <functional>
+#include <future>
 #include <string>
 #include <memory>
 #include "influxdb_config.h"
+#include "influxdb_http_events.h"
 
 namespace influxdb {
     namespace raw {
@@ -26,11 +29,20 @@ namespace influxdb {
             /// read queries
             std::string get(std::string const& query);
 
-            /// post measurements
-            void insert(std::string const& lines);
+            /// post measurements; pass an rvalue to hand the lines over
+            /// to the request body without a copy
+            void insert(std::string lines);
 
-            /// post measurements without waiting for an answer
-            void insert_async(std::string const& lines);
+            /// post measurements without waiting for an answer; the future
+            /// reports the failure, if any. At most http_config::max_in_flight
+            /// requests are on the wire, further calls block until one completes.
+            std::future<void> insert_async(std::string lines);
+
+            /// as above, reporting the outcome to on_complete instead
+            void insert_async(std::string lines, std::function<void(influxdb::api::http_result const&)> on_complete);
+
+            /// blocks until all insert_async requests have completed
+            void wait_for_in_flight();
 
             /// set username & password for basic authentication
             void with_authentication(std::string const& username, std::string const& password);
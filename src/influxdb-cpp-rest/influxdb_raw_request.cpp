@@ -0,0 +1,88 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+
+#include "influxdb_raw_request.h"
+#include "gzip.h"
+
+#include <utility>
+#include <vector>
+
+using namespace utility;
+using namespace web;
+using namespace web::http;
+
+namespace {
+    inline http_request request_to(uri const& target, string_t const& authorization) {
+        http_request request(methods::POST);
+        request.set_request_uri(target);
+
+        if (!authorization.empty()) {
+            request.headers().add(header_names::authorization, authorization);
+        }
+
+        return request;
+    }
+}
+
+http_request influxdb::raw::request_template::insert(
+    std::string lines,
+    influxdb::api::compression_config const& compression) const
+{
+    auto request = request_to(target, authorization);
+
+    if (compression.enabled && lines.size() >= compression.min_bytes) {
+        request.set_body(influxdb::utility::gzip(lines, compression.level));
+        request.headers().set_content_type(U("text/plain; charset=utf-8"));
+        request.headers().add(header_names::content_encoding, U("gzip"));
+    } else {
+        request.set_body(std::move(lines));
+    }
+
+    return request;
+}
+
+http_request influxdb::raw::request_template::query(string_t const& query) const
+{
+    // the same as uri_builder(target).append_query(U("q"), query),
+    // without taking the target apart and putting it back together
+    auto target_with_query = target.to_string();
+    target_with_query.append(U("?q="));
+    target_with_query.append(uri::encode_data_string(query));
+
+    auto request = request_to(uri(target_with_query), authorization);
+    request.set_body(std::string());
+    return request;
+}
+
+influxdb::raw::request_template influxdb::raw::write_template(uri const& base, string_t const& name, string_t const& authorization)
+{
+    uri_builder builder(base);
+    builder.append(U("/write"));
+    builder.append_query(U("db"), name);
+
+    return request_template{ builder.to_uri(), authorization };
+}
+
+influxdb::raw::request_template influxdb::raw::query_template(string_t const& authorization)
+{
+    return request_template{ uri(U("/query")), authorization };
+}
+
+string_t influxdb::raw::basic_authorization(std::string const& username, std::string const& password)
+{
+    if (username.empty())
+        return string_t();
+
+    std::vector<unsigned char> credentials;
+    credentials.reserve(username.size() + 1 + password.size());
+    credentials.insert(credentials.end(), username.begin(), username.end());
+    credentials.push_back(':');
+    credentials.insert(credentials.end(), password.begin(), password.end());
+
+    return U("Basic ") + conversions::to_base64(credentials);
+}
@@ -0,0 +1,47 @@
+/* * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include <cpprest/http_msg.h>
+#include <string>
+#include "influxdb_config.h"
+
+namespace influxdb {
+    namespace raw {
+
+        /// The parts of a request that do not change between requests of one
+        /// kind: the target and the precomputed Authorization header. Built
+        /// once per db (and on with_authentication), so that building a
+        /// request only adds the body or the query.
+        struct request_template {
+            /// /write?db=... for inserts, /query for queries
+            web::uri target;
+
+            /// "Basic ..." or empty
+            utility::string_t authorization;
+
+            /// a request posting lines to the target, gzipped if compression
+            /// is enabled and there are at least compression.min_bytes.
+            /// Uncompressed lines become the body as they are, without a copy.
+            web::http::http_request insert(
+                std::string lines,
+                influxdb::api::compression_config const& compression = influxdb::api::compression_config()
+            ) const;
+
+            /// a request posting the query statement to the target
+            web::http::http_request query(utility::string_t const& query) const;
+        };
+
+        /// POST /write?db=name, relative to base
+        request_template write_template(web::uri const& base, utility::string_t const& name, utility::string_t const& authorization);
+
+        /// POST /query?q=..., relative to the client's base uri
+        request_template query_template(utility::string_t const& authorization);
+
+        /// "Basic base64(username:password)", or empty without a username
+        utility::string_t basic_authorization(std::string const& username, std::string const& password);
+    }
+}
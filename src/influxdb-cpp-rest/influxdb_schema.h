@@ -0,0 +1,143 @@
+/* * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include "input_sanitizer.h"
+#include "influxdb_line.h"
+
+namespace influxdb {
+
+    namespace api {
+
+        /// Measurements whose name, tag keys and field keys are known at
+        /// compile time:
+        ///
+        ///     using cpu = schema::measurement<"cpu", schema::tags<"host", "region">, schema::fields<"usage", "idle">>;
+        ///     db.insert(cpu::line("server01", "us-west", 0.64, 0.36));
+        ///
+        /// Keys are validated by the compiler and the "cpu,host=" skeleton is
+        /// laid out once, so formatting a point only splices in the values.
+        /// The output is identical to the equivalent line(measurement, tags, values).
+        namespace schema {
+
+            /// A string literal usable as a template argument
+            template <std::size_t N>
+            struct fixed_string {
+                char value[N]{};
+
+                constexpr fixed_string(char const (&text)[N]) {
+                    for (std::size_t i = 0; i < N; ++i)
+                        value[i] = text[i];
+                }
+
+                constexpr std::size_t size() const {
+                    return N - 1;
+                }
+
+                constexpr std::string_view view() const {
+                    return std::string_view(value, N - 1);
+                }
+
+                constexpr bool valid_identifier() const {
+                    return ::influxdb::utility::detail::valid_identifier(value, N - 1);
+                }
+            };
+
+            template <fixed_string... Keys>
+            struct tags {};
+
+            template <fixed_string... Keys>
+            struct fields {};
+
+            template <fixed_string Name, typename Tags, typename Fields>
+            class measurement;
+
+            template <fixed_string Name, fixed_string... TagKeys, fixed_string... FieldKeys>
+            class measurement<Name, tags<TagKeys...>, fields<FieldKeys...>> {
+                static constexpr std::size_t key_count = sizeof...(TagKeys) + sizeof...(FieldKeys);
+
+                static_assert(sizeof...(FieldKeys) > 0, "a measurement needs at least one field");
+                static_assert(Name.valid_identifier(), "invalid measurement name");
+                static_assert((TagKeys.valid_identifier() && ...), "invalid tag key");
+                static_assert((FieldKeys.valid_identifier() && ...), "invalid field key");
+
+                static constexpr std::size_t skeleton_size =
+                    Name.size() + ((TagKeys.size() + 2) + ... + 0) + ((FieldKeys.size() + 2) + ... + 0);
+
+                // "cpu,host=" ",region=" " usage=" ",idle=" back to back;
+                // the value for key i goes after [bounds[i], bounds[i + 1])
+                struct skeleton_layout {
+                    std::array<char, skeleton_size> text{};
+                    std::array<std::size_t, key_count + 1> bounds{};
+                };
+
+                static constexpr skeleton_layout make_skeleton() {
+                    skeleton_layout skeleton{};
+                    std::size_t position = 0;
+                    std::size_t key = 0;
+
+                    auto put = [&](std::string_view part) {
+                        for (char c : part)
+                            skeleton.text[position++] = c;
+                    };
+                    auto put_key = [&](char separator, std::string_view name) {
+                        skeleton.text[position++] = separator;
+                        put(name);
+                        skeleton.text[position++] = '=';
+                        skeleton.bounds[++key] = position;
+                    };
+
+                    put(Name.view());
+                    (put_key(',', TagKeys.view()), ...);
+                    (put_key(key == sizeof...(TagKeys) ? ' ' : ',', FieldKeys.view()), ...);
+
+                    return skeleton;
+                }
+
+                static constexpr skeleton_layout skeleton = make_skeleton();
+
+                template <typename TValues, std::size_t... I>
+                static void append_values(std::string& res, TValues const& values, std::index_sequence<I...>) {
+                    ((res.append(skeleton.text.data() + skeleton.bounds[I], skeleton.bounds[I + 1] - skeleton.bounds[I]),
+                      detail::append_value(res, std::get<I>(values))), ...);
+                }
+
+            public:
+                /// the "measurement,tag=" ... "field=" skeleton, e.g. for diagnostics
+                static constexpr std::string_view skeleton_text() {
+                    return std::string_view(skeleton.text.data(), skeleton.text.size());
+                }
+
+                /// Formats one point from its tag values followed by its field
+                /// values, in schema order, optionally followed by a timestamp
+                template <typename... Args>
+                static ::influxdb::api::line line(Args const&... args) {
+                    static_assert(sizeof...(Args) == key_count || sizeof...(Args) == key_count + 1,
+                        "expected one value per tag and field key, optionally followed by a timestamp");
+
+                    std::string res;
+                    res.reserve(skeleton_size + 16 * key_count);
+
+                    auto const values = std::forward_as_tuple(args...);
+                    append_values(res, values, std::make_index_sequence<key_count>{});
+
+                    if constexpr (sizeof...(Args) == key_count + 1) {
+                        res.push_back(' ');
+                        detail::append_timestamp(res, std::get<key_count>(values));
+                    }
+
+                    return ::influxdb::api::line(std::move(res));
+                }
+            };
+        }
+    }
+}
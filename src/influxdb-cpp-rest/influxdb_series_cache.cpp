@@ -0,0 +1,183 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+
+#include "influxdb_series_cache.h"
+#include "input_sanitizer.h"
+
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+
+namespace {
+    // A series key as its two parts, so that lookups don't have to
+    // concatenate them first. An empty tag set has no separating comma.
+    struct key_parts {
+        std::string_view measurement;
+        std::string_view tags;
+    };
+
+    // FNV-1a, fed the parts as if they were one "measurement,tags" string
+    struct key_hash {
+        using is_transparent = void;
+
+        static std::size_t feed(std::size_t hash, std::string_view text) {
+            for (unsigned char c : text) {
+                hash ^= c;
+                hash *= 1099511628211ull;
+            }
+            return hash;
+        }
+
+        std::size_t operator()(std::string_view key) const {
+            return feed(14695981039346656037ull, key);
+        }
+
+        std::size_t operator()(key_parts const& key) const {
+            auto hash = feed(14695981039346656037ull, key.measurement);
+            if (!key.tags.empty()) {
+                hash = feed(hash, ",");
+                hash = feed(hash, key.tags);
+            }
+            return hash;
+        }
+    };
+
+    struct key_equal {
+        using is_transparent = void;
+
+        bool operator()(std::string_view a, std::string_view b) const {
+            return a == b;
+        }
+
+        bool operator()(key_parts const& a, std::string_view b) const {
+            if (a.tags.empty())
+                return b == a.measurement;
+
+            return b.size() == a.measurement.size() + 1 + a.tags.size() &&
+                b.substr(0, a.measurement.size()) == a.measurement &&
+                b[a.measurement.size()] == ',' &&
+                b.substr(a.measurement.size() + 1) == a.tags;
+        }
+
+        bool operator()(std::string_view a, key_parts const& b) const {
+            return (*this)(b, a);
+        }
+    };
+}
+
+namespace influxdb {
+    namespace api {
+
+        struct series_cache::impl {
+            using lru_list = std::list<std::shared_ptr<std::string const>>;
+
+            std::size_t const capacity;
+
+            mutable std::mutex mutex;
+            // most recently used first; the map keys point into the list's strings
+            lru_list recent;
+            std::unordered_map<std::string_view, lru_list::iterator, key_hash, key_equal> index;
+
+            std::atomic<std::uint64_t> hits{0};
+            std::atomic<std::uint64_t> misses{0};
+            std::atomic<std::uint64_t> evictions{0};
+
+            explicit impl(std::size_t capacity) :
+                capacity(capacity > 0 ? capacity : 1) {
+            }
+
+            series_key get(std::string_view measurement, std::string_view tags) {
+                // before the lookup, so that a measurement that happens to
+                // match a cached key as "measurement,tags" is refused too
+                ::influxdb::utility::throw_on_invalid_identifier(measurement);
+
+                key_parts const parts{ measurement, tags };
+
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+
+                    auto found = index.find(parts);
+                    if (found != index.end()) {
+                        recent.splice(recent.begin(), recent, found->second);
+                        ++hits;
+                        return series_key(*found->second);
+                    }
+                }
+
+                // format outside of the lock
+                std::string formatted;
+                formatted.reserve(measurement.size() + 1 + tags.size());
+                formatted += measurement;
+                if (!tags.empty()) {
+                    formatted.push_back(',');
+                    formatted += tags;
+                }
+                auto key = std::make_shared<std::string const>(std::move(formatted));
+
+                std::lock_guard<std::mutex> lock(mutex);
+                ++misses;
+
+                // another thread may have inserted the same series meanwhile
+                auto found = index.find(std::string_view(*key));
+                if (found != index.end()) {
+                    recent.splice(recent.begin(), recent, found->second);
+                    return series_key(*found->second);
+                }
+
+                if (index.size() >= capacity) {
+                    index.erase(std::string_view(*recent.back()));
+                    recent.pop_back();
+                    ++evictions;
+                }
+
+                recent.push_front(key);
+                index.emplace(std::string_view(*key), recent.begin());
+                return series_key(std::move(key));
+            }
+        };
+
+        series_cache::series_cache(std::size_t capacity) :
+            pimpl(std::make_unique<impl>(capacity)) {
+        }
+
+        series_cache::~series_cache() = default;
+
+        series_key series_cache::get(std::string_view measurement, key_value_pairs const& tags) {
+            return pimpl->get(measurement, tags.view());
+        }
+
+        std::size_t series_cache::size() const {
+            std::lock_guard<std::mutex> lock(pimpl->mutex);
+            return pimpl->index.size();
+        }
+
+        std::size_t series_cache::capacity() const {
+            return pimpl->capacity;
+        }
+
+        std::uint64_t series_cache::hits() const {
+            return pimpl->hits;
+        }
+
+        std::uint64_t series_cache::misses() const {
+            return pimpl->misses;
+        }
+
+        std::uint64_t series_cache::evictions() const {
+            return pimpl->evictions;
+        }
+
+        void series_cache::clear() {
+            std::lock_guard<std::mutex> lock(pimpl->mutex);
+            pimpl->index.clear();
+            pimpl->recent.clear();
+        }
+    }
+}
@@ -0,0 +1,49 @@
+/* * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include "influxdb_line.h"
+
+namespace influxdb {
+    namespace api {
+
+        /// Interns "measurement,tag=value,..." prefixes so that points of
+        /// a known series only format their fields and timestamp:
+        ///
+        ///     series_cache cache;
+        ///     auto cpu = cache.get("cpu", key_value_pairs("host", "server01"));
+        ///     db.insert(line(cpu, key_value_pairs("usage", 0.64)));
+        ///
+        /// Holds at most capacity() keys and evicts the least recently used
+        /// one when full. Thread-safe.
+        class series_cache {
+            struct impl;
+            std::unique_ptr<impl> pimpl;
+
+        public:
+            explicit series_cache(std::size_t capacity = 1024);
+            ~series_cache();
+
+            /// the key for measurement + tags, formatted and validated on a miss
+            series_key get(std::string_view measurement, key_value_pairs const& tags);
+
+            std::size_t size() const;
+            std::size_t capacity() const;
+
+            std::uint64_t hits() const;
+            std::uint64_t misses() const;
+            std::uint64_t evictions() const;
+
+            /// drops all keys; handed out keys stay valid
+            void clear();
+        };
+    }
+}
@@ -28,6 +28,8 @@ namespace influxdb {
             void create();
             void drop();
             void insert(line const& lines);
+            /// as above, handing the formatted lines over without a copy
+            void insert(line&& lines);
             void with_authentication(std::string const& username, std::string const& password);
         };
     }
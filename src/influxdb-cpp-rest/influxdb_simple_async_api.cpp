@@ -12,265 +12,984 @@
 #include "influxdb_simple_api.h"
 #include "influxdb_http_events.h"
 #include "input_sanitizer.h"
-#include "influxdb_line.h"
+#include "bounded_queue.h"
+#include "line_protocol.h"
+#include "spill_queue.h"
+#include "adaptive_batch.h"
+#include "series_sort.h"
+#include "point_coalesce.h"
+#include "point_aggregate.h"
+#include "influxdb_metrics.h"
 
 #include <rxcpp/rx.hpp>
+#include <algorithm>
 #include <chrono>
 #include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string_view>
 #include <thread>
+#include <vector>
 
 using namespace influxdb::utility;
 
 struct influxdb::async_api::simple_db::impl {
-    influxdb::raw::db_utf8 db;
+    using clock = std::chrono::steady_clock;
+
+    // Formatted lines travel from insert() to a flusher thread through a
+    // bounded lock-free queue. The flusher batches them by count or age and
+    // hands the batches to its own HTTP client.
+    struct worker {
+        impl& owner;
+        std::unique_ptr<influxdb::raw::db_utf8> db;
+        influxdb::utility::bounded_queue<std::string> queue;
+        std::atomic<bool> stopping;
+        // lines still queued when stopping past this are discarded
+        clock::time_point stop_deadline;
+        // non-zero while the flusher sleeps: the queue size that should wake it
+        std::atomic<std::size_t> wake_at;
+        std::mutex wake_mutex;
+        std::condition_variable wake;
+        std::thread flusher;
+        // producers waiting for room in the queue, see wait_for_room()
+        std::atomic<unsigned> blocked;
+        std::mutex room_mutex;
+        std::condition_variable room;
+
+        // Queued lines are counted when insert() takes them and again once
+        // they are resolved: acknowledged, failed, spilled or dropped. flush() waits
+        // for the second count to reach the first.
+        std::atomic<std::uint64_t> enqueued;
+        std::atomic<std::uint64_t> completed;
+        // of the enqueued lines, those left with the caller: a full queue
+        // for try_insert(), or shutdown while waiting for room
+        std::atomic<std::uint64_t> rejected;
+        // flush() asks the flusher to send its partial batch now
+        std::atomic<std::uint64_t> flush_requests;
+        std::uint64_t flush_seen;
+
+        // Batches the server did not take, if spilling is configured. While
+        // it is not empty, new batches queue up behind them on disk.
+        std::unique_ptr<influxdb::utility::spill_queue> spill;
+        // With spilling, one batch is on the wire at a time: the next one
+        // is sent only once it is known whether the server took it, see
+        // await_response(). Spilled batches are replayed the same way.
+        std::mutex response_mutex;
+        std::condition_variable responded;
+        bool awaiting;
+        // when the flusher tries the oldest spilled batch again, see replay_at()
+        clock::time_point next_replay;
+        // see batch_config::sort_by_series
+        influxdb::utility::series_sorter sorter;
+        // see batch_config::coalesce
+        influxdb::utility::point_coalescer coalescer;
+        // see db_config::aggregate, nullptr without aggregation
+        std::unique_ptr<influxdb::utility::point_aggregator> aggregator;
+
+        worker(impl& owner, std::unique_ptr<influxdb::raw::db_utf8> db, std::size_t capacity,
+            std::unique_ptr<influxdb::utility::spill_queue> spill, std::unique_ptr<influxdb::utility::point_aggregator> aggregator) :
+            owner(owner),
+            db(std::move(db)),
+            queue(capacity),
+            stopping(false),
+            stop_deadline(clock::time_point::max()),
+            wake_at(0),
+            blocked(0),
+            enqueued(0),
+            completed(0),
+            rejected(0),
+            flush_requests(0),
+            flush_seen(0),
+            spill(std::move(spill)),
+            awaiting(false),
+            next_replay(clock::now()),
+            aggregator(std::move(aggregator))
+        {
+        }
+
+        void start()
+        {
+            flusher = std::thread([this] { flush_loop(); });
+        }
+
+        // lets the flusher send what has been queued until deadline, and stop
+        void stop(clock::time_point deadline)
+        {
+            stop_deadline = deadline;
+            stopping = true;
+            wake_flusher();
+
+            // producers blocked on a full queue give up
+            std::lock_guard<std::mutex> lock(room_mutex);
+            room.notify_all();
+        }
+
+        void request_flush()
+        {
+            flush_requests.fetch_add(1);
+            wake_flusher();
+        }
+
+        void resolve(std::uint64_t lines)
+        {
+            completed.fetch_add(lines);
+            owner.notify_flushed();
+        }
+
+        void join()
+        {
+            if (flusher.joinable()) {
+                flusher.join();
+            }
+
+            // the requests still on the wire refer to the owner in their callbacks
+            db->wait_for_in_flight();
+        }
+
+        // Hands a batch to the HTTP client without waiting for the response;
+        // blocks only while http_config::max_in_flight requests are on the wire.
+        // The batch is moved on into the request body; with spilling, a copy
+        // is kept for the case that the server does not take it. count is
+        // the number of lines in the batch, queued the number of queued
+        // lines they stand for, see next_line().
+        void send(std::string lines, unsigned count, unsigned queued)
+        {
+            auto kept = spill ? std::make_shared<std::string>(lines) : nullptr;
+            if (kept) {
+                expect_response();
+            }
+            owner.batch_lines.record(count);
+            owner.batch_bytes.record(lines.size());
+            auto const generation = owner.batching.generation();
+            auto const start = clock::now();
+
+            db->insert_async(std::move(lines), [this, queued, kept, generation, start](influxdb::api::http_result const& result) {
+                auto const latency = owner.record_latency(start);
+                // a request refused for its content says nothing about the load
+                if (result.success || retriable(result)) {
+                    owner.batching.on_response(generation, latency, !result.success);
+                }
+                if (result.success) {
+                    owner.lines_sent.fetch_add(queued, std::memory_order_relaxed);
+                } else if (kept && retriable(result) && spill->append(*kept, queued)) {
+                    std::cerr << "async_api::insert failed: " << result.error_message << " -> Spilling " << result.bytes_sent << " bytes" << std::endl;
+                    owner.lines_spilled.fetch_add(queued, std::memory_order_relaxed);
+                    wake_flusher();
+                } else {
+                    std::cerr << "async_api::insert failed: " << result.error_message << " -> Dropping " << result.bytes_sent << " bytes" << std::endl;
+                    owner.lines_failed.fetch_add(queued, std::memory_order_relaxed);
+                }
+
+                if (owner.started.load()) {
+                    owner.publish(result, latency);
+                }
+
+                if (kept) {
+                    on_response(!result.success && retriable(result));
+                }
+                resolve(queued);
+            });
+        }
+
+        // with spilling, before a batch is handed to the HTTP client
+        void expect_response()
+        {
+            std::lock_guard<std::mutex> lock(response_mutex);
+            awaiting = true;
+        }
+
+        // The batch on the wire is sent, spilled or failed now. retry if the
+        // server is unavailable: the spilled batches wait for the next attempt.
+        void on_response(bool retry)
+        {
+            {
+                std::lock_guard<std::mutex> lock(response_mutex);
+                awaiting = false;
+                if (retry) {
+                    next_replay = clock::now() + owner.spill_retry;
+                }
+            }
+            responded.notify_all();
+            // the flusher may be waiting to replay
+            wake_flusher();
+        }
+
+        // waits until the server answered the batch on the wire, if any
+        void await_response()
+        {
+            std::unique_lock<std::mutex> lock(response_mutex);
+            responded.wait(lock, [this] { return !awaiting; });
+        }
+
+        // Returns whether the line was queued; a full queue is handled
+        // according to policy.
+        bool push(std::string&& line, influxdb::api::overflow_policy policy)
+        {
+            enqueued.fetch_add(1);
+            if (!queue.try_push(std::move(line))) {
+                switch (policy) {
+                case influxdb::api::overflow_policy::block:
+                    if (!wait_for_room(line)) {
+                        rejected.fetch_add(1);
+                        resolve(1);
+                        return false;
+                    }
+                    break;
+
+                case influxdb::api::overflow_policy::drop_oldest: {
+                    std::string oldest;
+                    while (!queue.try_push(std::move(line))) {
+                        if (queue.try_pop(oldest)) {
+                            owner.dropped.fetch_add(1, std::memory_order_relaxed);
+                            resolve(1);
+                        }
+                    }
+                    break;
+                }
+
+                case influxdb::api::overflow_policy::drop_newest:
+                case influxdb::api::overflow_policy::fail:
+                    owner.dropped.fetch_add(1, std::memory_order_relaxed);
+                    resolve(1);
+                    wake_flusher();
+                    return false;
+                }
+            }
+
+            notify_flusher();
+            return true;
+        }
+
+        // The flusher is behind: waits until it takes lines from the queue
+        // and queues line. False if the database shuts down meanwhile.
+        bool wait_for_room(std::string& line)
+        {
+            blocked.fetch_add(1);
+            wake_flusher();
+
+            bool queued = false;
+            {
+                std::unique_lock<std::mutex> lock(room_mutex);
+                while (owner.started.load()) {
+                    // pairs with the fence in notify_room(): either this
+                    // finds the room, or the flusher sees this waiting
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+                    if (queue.try_push(std::move(line))) {
+                        queued = true;
+                        break;
+                    }
+                    room.wait_for(lock, std::chrono::milliseconds(100));
+                }
+            }
+
+            blocked.fetch_sub(1);
+            return queued;
+        }
+
+        // called by the flusher after it took lines from the queue
+        void notify_room()
+        {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (blocked.load(std::memory_order_relaxed) != 0) {
+                std::lock_guard<std::mutex> lock(room_mutex);
+                room.notify_all();
+            }
+        }
+
+        // never waits and never drops: false, with line left as it was, if the queue is full
+        bool try_push(std::string&& line)
+        {
+            enqueued.fetch_add(1);
+            if (!queue.try_push(std::move(line))) {
+                rejected.fetch_add(1);
+                resolve(1);
+                return false;
+            }
+
+            notify_flusher();
+            return true;
+        }
+
+        void notify_flusher()
+        {
+            // pairs with the fence in sleep(): either the flusher sees the
+            // line, or this sees that it sleeps
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            auto const threshold = wake_at.load(std::memory_order_relaxed);
+            if (threshold != 0 && queue.size() >= threshold) {
+                wake_flusher();
+            }
+        }
+
+        void wake_flusher()
+        {
+            std::lock_guard<std::mutex> lock(wake_mutex);
+            wake.notify_one();
+        }
+
+        void flush_loop()
+        {
+            auto const window_max_bytes = owner.window_max_bytes;
+
+            std::string batch;
+            unsigned lines = 0;
+            // the queued lines the batch stands for, more than lines with aggregation
+            unsigned queued = 0;
+            auto deadline = clock::time_point::max();
+
+            // a line that did not fit into the previous batch starts the next one
+            std::string line;
+            bool held = false;
+            // the queued lines that line stands for, see next_line()
+            unsigned points = 1;
+
+            for (;;) {
+                // may change with every response, see adaptive_batch
+                auto const window_max_lines = owner.batching.max_lines();
+                auto const requested = flush_requests.load();
+                // flush() and stopping send the open aggregates too
+                bool const close_all = requested != flush_seen || stopping.load();
+                bool full = false;
+                while (lines < window_max_lines && (held || next_line(line, points, close_all))) {
+                    held = false;
+                    if (lines > 0 && !fits(batch, line)) {
+                        held = true;
+                        full = true;
+                        break;
+                    }
+                    if (lines == 0) {
+                        deadline = clock::now() + owner.batching.max_time();
+                    }
+                    batch += line;
+                    batch += '\n';
+                    ++lines;
+                    queued += points;
+                }
+                notify_room();
+
+                full = full || (window_max_bytes != 0 && batch.size() >= window_max_bytes);
+                bool const stop = stopping.load();
+
+                if (stop && clock::now() >= stop_deadline) {
+                    discard(queued + (held ? points : 0) + (aggregator ? aggregator->pending() : 0));
+                    return;
+                }
+
+                if (lines > 0 && (full || lines >= window_max_lines || stop || requested != flush_seen || clock::now() >= deadline)) {
+                    auto const size = batch.size();
+                    flush(std::move(batch), lines, queued);
+                    // the next batch is likely to be about as large
+                    batch = std::string();
+                    batch.reserve(size);
+                    lines = 0;
+                    queued = 0;
+                    deadline = clock::time_point::max();
+                    continue;
+                }
+
+                if (stop) {
+                    // aggregates still open when stopping was seen go next round
+                    if (aggregator && aggregator->pending() > 0) {
+                        continue;
+                    }
+                    return;
+                }
+
+                // all lines queued before the flush() were handed over
+                flush_seen = requested;
+
+                if (replay_due()) {
+                    replay();
+                    continue;
+                }
+
+                // an empty batch waits for the first line, a started one for
+                // its deadline or for enough lines to complete it; spilled
+                // batches wait for their next attempt
+                auto wake_by = spill && !spill->empty() ? std::min(deadline, replay_at()) : deadline;
+                if (aggregator) {
+                    wake_by = std::min(wake_by, aggregator->next_due());
+                }
+                sleep(lines == 0 ? 1 : window_max_lines - lines, wake_by);
+            }
+        }
+
+        // The next line for the batch and the number of queued lines it
+        // stands for: a queued line, or the aggregate of a window that is
+        // due, of every open window if close_all
+        bool next_line(std::string& line, unsigned& points, bool close_all)
+        {
+            points = 1;
+            if (!aggregator) {
+                return queue.try_pop(line);
+            }
+
+            auto now = clock::now();
+            for (unsigned taken = 1;; ++taken) {
+                bool const aggregate = aggregator->pop(line, points, now, false) ||
+                    (queue.empty() && aggregator->pop(line, points, now, close_all));
+                if (aggregate) {
+                    owner.lines_aggregated.fetch_add(points, std::memory_order_relaxed);
+                    return true;
+                }
+                if (!queue.try_pop(line)) {
+                    return false;
+                }
+                if (!aggregator->add(line, now)) {
+                    return true;
+                }
+                // windows may fall due while a long run of lines is aggregated
+                if (taken % 64 == 0) {
+                    now = clock::now();
+                }
+            }
+        }
+
+        // whether line can join batch without exceeding window_max_bytes
+        bool fits(std::string const& batch, std::string const& line) const
+        {
+            return owner.window_max_bytes == 0 || batch.size() + line.size() + 1 <= owner.window_max_bytes;
+        }
+
+        void sleep(std::size_t threshold, clock::time_point deadline)
+        {
+            std::unique_lock<std::mutex> lock(wake_mutex);
+            wake_at.store(std::min(threshold, queue.capacity() / 2), std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            if (queue.size() < wake_at.load(std::memory_order_relaxed) && !stopping.load() && flush_requests.load() == flush_seen && !replay_due()) {
+                if (deadline == clock::time_point::max()) {
+                    wake.wait(lock);
+                } else {
+                    wake.wait_until(lock, deadline);
+                }
+            }
+
+            wake_at.store(0, std::memory_order_relaxed);
+        }
+
+        // see send() for count and queued
+        void flush(std::string&& batch, unsigned count, unsigned queued)
+        {
+            if (owner.coalesce && count > 1) {
+                auto const merged = coalescer.coalesce(batch);
+                owner.lines_coalesced.fetch_add(merged, std::memory_order_relaxed);
+                count -= static_cast<unsigned>(merged);
+            }
+            if (owner.sort_by_series && count > 1) {
+                sorter.sort(batch);
+            }
+
+            // keeps the order: the spilled batches go first, and a batch
+            // still on the wire may yet join them
+            if (spill && spill->empty()) {
+                await_response();
+            }
+            if (spill && !spill->empty()) {
+                if (spill->append(batch, queued)) {
+                    owner.lines_spilled.fetch_add(queued, std::memory_order_relaxed);
+                } else {
+                    std::cerr << "async_api: spill queue full -> Dropping " << batch.size() << " bytes" << std::endl;
+                    owner.dropped.fetch_add(queued, std::memory_order_relaxed);
+                }
+                resolve(queued);
+                return;
+            }
+
+            try {
+                send(std::move(batch), count, queued);
+            } catch (const std::runtime_error& ex) {
+                if (spill) {
+                    on_response(false);
+                }
+                if (owner.observed()) {
+                    influxdb::api::http_result result(false, "insert", 0);
+                    result.error_message = ex.what();
+                    owner.publish(result, std::chrono::microseconds::zero());
+                }
+                std::cerr << ex.what() << std::endl;
+                owner.lines_failed.fetch_add(queued, std::memory_order_relaxed);
+                resolve(queued);
+            }
+        }
+
+        // no response or a server error: the batch may go through later
+        static bool retriable(influxdb::api::http_result const& result)
+        {
+            return result.status_code == 0 || result.status_code >= 500;
+        }
+
+        // Sends the oldest spilled batch without waiting for the response;
+        // it leaves the spill queue unless the server is still unavailable.
+        // Meanwhile the flusher keeps batching, behind it on disk.
+        void replay()
+        {
+            std::string batch;
+            unsigned count = 0;
+            if (!spill->front(batch, count)) {
+                return;
+            }
+
+            auto const bytes = batch.size();
+            auto const start = clock::now();
+            expect_response();
+
+            try {
+                db->insert_async(std::move(batch), [this, bytes, count, start](influxdb::api::http_result const& result) {
+                    auto const latency = owner.record_latency(start);
+                    if (result.success) {
+                        spill->pop();
+                        spill->replayed(bytes, std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - start));
+                        owner.lines_sent.fetch_add(count, std::memory_order_relaxed);
+                    } else if (!retriable(result)) {
+                        std::cerr << "async_api::insert failed: " << result.error_message << " -> Dropping " << bytes << " spilled bytes" << std::endl;
+                        spill->pop();
+                        owner.lines_failed.fetch_add(count, std::memory_order_relaxed);
+                    }
+
+                    if (owner.started.load()) {
+                        owner.publish(result, latency);
+                    }
+
+                    on_response(!result.success && retriable(result));
+                });
+            } catch (const std::runtime_error& ex) {
+                std::cerr << ex.what() << std::endl;
+                on_response(true);
+            }
+        }
+
+        // when the oldest spilled batch is due, time_point::max() while a
+        // batch is on the wire
+        clock::time_point replay_at()
+        {
+            std::lock_guard<std::mutex> lock(response_mutex);
+            return awaiting ? clock::time_point::max() : next_replay;
+        }
+
+        bool replay_due()
+        {
+            return spill && !spill->empty() && clock::now() >= replay_at();
+        }
+
+        // past the shutdown deadline: drops the lines not sent yet
+        void discard(std::uint64_t unsent)
+        {
+            std::string line;
+            while (queue.try_pop(line)) {
+                ++unsent;
+            }
+            notify_room();
+
+            if (unsent > 0) {
+                std::cerr << "async_api: shutdown deadline passed -> Dropping " << unsent << " lines" << std::endl;
+                owner.dropped.fetch_add(unsent, std::memory_order_relaxed);
+                resolve(unsent);
+            }
+        }
+    };
+
     influxdb::api::simple_db simpledb;
     std::atomic<bool> started;
-    rxcpp::subscription listener;
-    rxcpp::subjects::subject<influxdb::api::line> subj;
     rxcpp::subjects::subject<influxdb::api::http_result> http_events_subj;
+    // completions arrive on the HTTP client's threads, the subject and the
+    // handler take them one at a time
+    std::mutex http_events_mutex;
+    // see on_http_event(); http_handler is read only while http_handler_set
+    std::function<void(influxdb::api::http_event const&)> http_handler;
+    std::atomic<bool> http_handler_set;
+    std::atomic<unsigned> http_sample_every;
+    std::atomic<std::uint64_t> http_successes;
     unsigned window_max_lines;
     std::chrono::milliseconds window_max_ms;
-    // Single shared scheduler and worker for all operations (both batching and no-batching)
-    // This prevents thread explosion by reusing a single thread pool
-    // Worker is stored to ensure it outlives all subscriptions (RxCpp issue #437)
-    rxcpp::schedulers::scheduler shared_scheduler;
-    rxcpp::schedulers::worker shared_worker;
+    // 0 for no limit
+    std::size_t window_max_bytes;
+    // the limits in effect, within window_max_lines and window_max_ms
+    influxdb::utility::adaptive_batch batching;
+    bool sort_by_series;
+    bool coalesce;
+    influxdb::api::overflow_policy overflow;
+    // lines lost to overflow, see insert()
+    std::atomic<unsigned long long> dropped;
+    // 0 for no limit
+    std::chrono::milliseconds shutdown_timeout;
+    std::chrono::milliseconds spill_retry;
+    // see metrics()
+    std::atomic<std::uint64_t> lines_sent;
+    std::atomic<std::uint64_t> lines_failed;
+    std::atomic<std::uint64_t> lines_spilled;
+    std::atomic<std::uint64_t> lines_coalesced;
+    std::atomic<std::uint64_t> lines_aggregated;
+    influxdb::api::histogram batch_lines;
+    influxdb::api::histogram batch_bytes;
+    influxdb::api::histogram latency_us;
+    // flush() waits here for the workers to resolve lines
+    std::mutex flush_mutex;
+    std::condition_variable flushed;
+    std::atomic<unsigned> flush_waiters;
+    // the lines of a series always go to the same worker, see worker_for()
+    std::vector<std::unique_ptr<worker>> workers;
 
     impl(std::string const& url, std::string const& name, unsigned window_max_lines, unsigned window_max_ms) :
-        db(url, name),
         simpledb(url, name),
         started(false),
-        window_max_lines(window_max_lines),
+        http_handler_set(false),
+        http_sample_every(1),
+        http_successes(0),
+        window_max_lines(std::max(window_max_lines, 1u)),
         window_max_ms(std::chrono::milliseconds(window_max_ms)),
-        // Always use shared event loop scheduler for all scenarios
-        // Single thread pool prevents thread explosion
-        // Create worker immediately to avoid RxCpp issue #185 (make_event_loop inner empty)
-        shared_scheduler(rxcpp::schedulers::make_event_loop()),
-        shared_worker(shared_scheduler.create_worker())
+        window_max_bytes(0),
+        batching(influxdb::api::batch_config(this->window_max_lines, window_max_ms)),
+        sort_by_series(false),
+        coalesce(false),
+        overflow(influxdb::api::overflow_policy::block),
+        dropped(0),
+        shutdown_timeout(0),
+        spill_retry(0),
+        lines_sent(0),
+        lines_failed(0),
+        lines_spilled(0),
+        lines_coalesced(0),
+        lines_aggregated(0),
+        flush_waiters(0)
     {
         throw_on_invalid_identifier(name);
+        workers.push_back(std::make_unique<worker>(*this,
+            std::make_unique<influxdb::raw::db_utf8>(url, name),
+            queue_capacity(0, window_max_lines),
+            nullptr,
+            nullptr));
         start_once();
     }
 
     impl(std::string const& url, std::string const& name, influxdb::api::db_config const& config) :
-        db(url, name, config.http),
         simpledb(url, name, config.http),
         started(false),
-        window_max_lines(config.batch.max_lines),
+        http_handler_set(false),
+        http_sample_every(1),
+        http_successes(0),
+        window_max_lines(std::max(config.batch.max_lines, 1u)),
         window_max_ms(config.batch.max_time_ms),
-        // Always use shared event loop scheduler for all scenarios
-        // Single thread pool prevents thread explosion
-        // Create worker immediately to avoid RxCpp issue #185 (make_event_loop inner empty)
-        shared_scheduler(rxcpp::schedulers::make_event_loop()),
-        shared_worker(shared_scheduler.create_worker())
+        window_max_bytes(config.batch.max_bytes),
+        batching(config.batch),
+        sort_by_series(config.batch.sort_by_series),
+        coalesce(config.batch.coalesce),
+        overflow(config.queue.overflow),
+        dropped(0),
+        shutdown_timeout(config.queue.shutdown_timeout_ms),
+        spill_retry(config.spill.retry_ms),
+        lines_sent(0),
+        lines_failed(0),
+        lines_spilled(0),
+        lines_coalesced(0),
+        lines_aggregated(0),
+        flush_waiters(0)
     {
         throw_on_invalid_identifier(name);
+        for (unsigned i = 0; i < std::max(config.queue.workers, 1u); ++i) {
+            workers.push_back(std::make_unique<worker>(*this,
+                std::make_unique<influxdb::raw::db_utf8>(url, name, config.http),
+                queue_capacity(config.queue.capacity, config.batch.max_lines),
+                spill_queue_for(config.spill, i),
+                config.aggregate.window_ms != 0 ? std::make_unique<influxdb::utility::point_aggregator>(config.aggregate) : nullptr));
+        }
         start_once();
     }
 
+    static std::unique_ptr<influxdb::utility::spill_queue> spill_queue_for(influxdb::api::spill_config const& spill, unsigned worker)
+    {
+        if (spill.directory.empty())
+            return nullptr;
+        return std::make_unique<influxdb::utility::spill_queue>(
+            spill.directory + "/" + std::to_string(worker), spill.segment_bytes, spill.max_bytes);
+    }
+
+    // by default room for two batches, within reasonable memory bounds
+    static std::size_t queue_capacity(std::size_t capacity, unsigned window_max_lines) {
+        if (capacity != 0)
+            return capacity;
+        return std::clamp<std::size_t>(2 * static_cast<std::size_t>(window_max_lines), 1024, 65536);
+    }
+
+    // whether publish() would hand an event to anyone
+    bool observed() const
+    {
+        return http_handler_set.load(std::memory_order_relaxed) || http_events_subj.has_observers();
+    }
+
+    // duration, if not zero, replaces the result's millisecond one in the http_event
+    void publish(influxdb::api::http_result const& result, std::chrono::microseconds duration)
+    {
+        if (http_handler_set.load(std::memory_order_relaxed) && sampled(result)) {
+            auto event = influxdb::api::http_event::from(result);
+            if (duration.count() != 0) {
+                event.duration_us = static_cast<std::uint32_t>(duration.count());
+            }
+
+            std::lock_guard<std::mutex> lock(http_events_mutex);
+            if (http_handler) {
+                try {
+                    http_handler(event);
+                } catch (...) {
+                    // the handler must not stop the completion
+                }
+            }
+        }
+
+        if (!http_events_subj.has_observers()) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(http_events_mutex);
+        try {
+            http_events_subj.get_subscriber().on_next(result);
+        } catch (...) {
+            // Subject may be destroyed, ignore during shutdown
+        }
+    }
+
+    // failures are always reported, successes one in http_sample_every
+    bool sampled(influxdb::api::http_result const& result)
+    {
+        if (!result.success) {
+            return true;
+        }
+        auto const every = http_sample_every.load(std::memory_order_relaxed);
+        return every <= 1 || http_successes.fetch_add(1, std::memory_order_relaxed) % every == 0;
+    }
+
+    void on_http_event(std::function<void(influxdb::api::http_event const&)> handler, unsigned sample_every)
+    {
+        std::lock_guard<std::mutex> lock(http_events_mutex);
+        bool const set = static_cast<bool>(handler);
+        http_handler = std::move(handler);
+        http_sample_every.store(std::max(sample_every, 1u), std::memory_order_relaxed);
+        http_handler_set.store(set, std::memory_order_relaxed);
+    }
+
+    std::chrono::microseconds record_latency(clock::time_point start)
+    {
+        auto const latency = std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - start);
+        latency_us.record(static_cast<std::uint64_t>(latency.count()));
+        return latency;
+    }
+
+    influxdb::api::async_metrics metrics() const
+    {
+        influxdb::api::async_metrics result;
+        for (auto const& w : workers) {
+            // in this order, a rejected line is always among the enqueued ones
+            auto const rejected = w->rejected.load();
+            result.lines_enqueued += w->enqueued.load() - rejected;
+        }
+        result.lines_sent = lines_sent.load(std::memory_order_relaxed);
+        result.lines_failed = lines_failed.load(std::memory_order_relaxed);
+        result.lines_spilled = lines_spilled.load(std::memory_order_relaxed);
+        result.lines_coalesced = lines_coalesced.load(std::memory_order_relaxed);
+        result.lines_aggregated = lines_aggregated.load(std::memory_order_relaxed);
+        result.lines_dropped = dropped.load(std::memory_order_relaxed);
+        result.queue_depth = queue_depth();
+        result.queue_capacity = queue_capacity();
+        result.batch_max_lines = batching.max_lines();
+        result.batch_max_time_ms = static_cast<unsigned>(batching.max_time().count());
+        result.batch_lines = batch_lines.snapshot();
+        result.batch_bytes = batch_bytes.snapshot();
+        result.latency_us = latency_us.snapshot();
+        return result;
+    }
+
+    void notify_flushed()
+    {
+        // pairs with the increment in wait_for(): either the waiter sees
+        // the resolved lines, or this sees the waiter
+        if (flush_waiters.load() == 0) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(flush_mutex);
+        flushed.notify_all();
+    }
+
+    // Sends the partial batches now and waits until all lines queued so
+    // far are acknowledged, failed, spilled or dropped, at most timeout (0 for no
+    // limit). Returns whether they are.
+    bool flush(std::chrono::milliseconds timeout)
+    {
+        auto const targets = enqueued();
+        for (auto& w : workers) {
+            w->request_flush();
+        }
+
+        return wait_for(targets, timeout);
+    }
+
+    // per worker, the number of lines inserted so far
+    std::vector<std::uint64_t> enqueued() const
+    {
+        std::vector<std::uint64_t> counts;
+        counts.reserve(workers.size());
+        for (auto const& w : workers) {
+            counts.push_back(w->enqueued.load());
+        }
+        return counts;
+    }
+
+    // waits until each worker resolved as many lines as targets has for it
+    bool wait_for(std::vector<std::uint64_t> const& targets, std::chrono::milliseconds timeout)
+    {
+        auto resolved = [this, &targets] {
+            for (std::size_t i = 0; i < workers.size(); ++i) {
+                if (workers[i]->completed.load() < targets[i]) {
+                    return false;
+                }
+            }
+            return true;
+        };
+
+        // nothing pending: no need to wait
+        if (resolved()) {
+            return true;
+        }
+
+        flush_waiters.fetch_add(1);
+        bool done;
+        {
+            std::unique_lock<std::mutex> lock(flush_mutex);
+            if (timeout == std::chrono::milliseconds::zero()) {
+                flushed.wait(lock, resolved);
+                done = true;
+            } else {
+                done = flushed.wait_for(lock, timeout, resolved);
+            }
+        }
+        flush_waiters.fetch_sub(1);
+        return done;
+    }
+
     void start_once()
     {
         if (started)
             return;
 
         started = true;
+        for (auto& w : workers) {
+            w->start();
+        }
+    }
 
-        auto incoming_requests = subj.get_observable()
-            .map([](auto&& line) {
-                return line.get();
-            });
+    worker& worker_for(std::string_view line)
+    {
+        return *workers[std::hash<std::string_view>()(series_of(line)) % workers.size()];
+    }
 
-            // Create coordination from our instance scheduler to ensure proper lifetime
-            // This avoids the crash-prone static synchronize_event_loop() pattern
-            // The coordination is tied to shared_scheduler/shared_worker lifetime
-            // Use observe_on_one_worker with scheduler (not worker) to create coordination
-            auto coordination = rxcpp::observe_on_one_worker(shared_scheduler);
-            
-            // For true "no-batching" mode (1 line / 0ms), bypass windowing entirely
-            // and send each line immediately. This ensures we get ~1 request per line
-            // instead of batching due to scheduler tick granularity.
-            if (window_max_lines == 1 && window_max_ms.count() == 0) {
-                // No-batching: send each line immediately without windowing
-                listener = incoming_requests
-                    .observe_on(coordination)
-                    .subscribe([this](std::string const& line_str) {
-                        if (!started.load()) {
-                            return;
-                        }
-                        
-                        auto start_time = std::chrono::steady_clock::now();
-                        auto bytes_sent = line_str.size();
-                        
-                        try {
-                            db.insert_async(line_str);
-                            
-                            // Success event
-                            if (started.load()) {
-                                auto end_time = std::chrono::steady_clock::now();
-                                auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
-                                influxdb::api::http_result result(true, "insert", bytes_sent);
-                                result.status_code = 204; // NoContent
-                                result.duration_ms = duration;
-                                result.bytes_received = 0;
-                                try {
-                                    http_events_subj.get_subscriber().on_next(result);
-                                } catch (...) {
-                                    // Subject may be destroyed, ignore during shutdown
-                                }
-                            }
-                        } catch (const std::runtime_error& e) {
-                            // Failure event
-                            if (started.load()) {
-                                auto end_time = std::chrono::steady_clock::now();
-                                auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
-                                influxdb::api::http_result result(false, "insert", bytes_sent);
-                                result.error_message = e.what();
-                                result.duration_ms = duration;
-                                try {
-                                    http_events_subj.get_subscriber().on_next(result);
-                                } catch (...) {
-                                    // Subject may be destroyed, ignore during shutdown
-                                }
-                            }
-                            // Still print error but don't throw to avoid breaking the observable chain
-                            std::cerr << "async_api::insert failed: " << e.what() << " -> Dropping " << bytes_sent << " bytes" << std::endl;
-                        }
-                    },
-                    [this](std::exception_ptr ep) {
-                        if (!started.load()) {
-                            return;
-                        }
-                        
-                        try { std::rethrow_exception(ep); }
-                        catch (const std::runtime_error& ex) {
-                            influxdb::api::http_result result(false, "insert", 0);
-                            result.error_message = ex.what();
-                            try {
-                                http_events_subj.get_subscriber().on_next(result);
-                            } catch (...) {
-                                // Subject may be destroyed, ignore during shutdown
-                            }
-                            std::cerr << ex.what() << std::endl;
-                        }
-                    });
-            } else {
-                // Batching mode: use windowing
-                listener = incoming_requests
-                    .window_with_time_or_count(window_max_ms, (int)window_max_lines, coordination)
-                .subscribe(
-                    [this, coordination](rxcpp::observable<std::string> window) {
-                        // Use observe_on to ensure the nested subscription runs on the correct thread
-                        // This prevents crashes from accessing subjects across threads
-                        // Don't capture subscriber - check validity before each use to avoid crashes
-                        window.scan(
-                            std::make_shared<std::string>(),
-                            [](std::shared_ptr<std::string> const& w, std::string const& v) {
-                                *w += v;
-                                *w += '\n';
-                                return w;
-                            })
-                        .start_with(std::make_shared<std::string>())
-                        .last()
-                        .observe_on(coordination)
-                        .subscribe([this](std::shared_ptr<std::string> const& w) {
-                            // Check if we're still started before accessing subject
-                            // This prevents crashes when the object is being destroyed
-                            if (!started.load()) {
-                                return;
-                            }
-                            
-                            if (!w->empty()) {
-                                auto start_time = std::chrono::steady_clock::now();
-                                auto bytes_sent = w->size();
-                                
-                                try {
-                                    db.insert_async(*w);
-                                    
-                                    // Success event - check started again before accessing subject
-                                    if (started.load()) {
-                                        auto end_time = std::chrono::steady_clock::now();
-                                        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
-                                        influxdb::api::http_result result(true, "insert", bytes_sent);
-                                        result.status_code = 204; // NoContent
-                                        result.duration_ms = duration;
-                                        result.bytes_received = 0; // No response body for successful inserts
-                                        try {
-                                            http_events_subj.get_subscriber().on_next(result);
-                                        } catch (...) {
-                                            // Subject may be destroyed, ignore during shutdown
-                                        }
-                                    }
-                                } catch (const std::runtime_error& e) {
-                                    // Failure event - check started again before accessing subject
-                                    if (started.load()) {
-                                        auto end_time = std::chrono::steady_clock::now();
-                                        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
-                                        influxdb::api::http_result result(false, "insert", bytes_sent);
-                                        result.error_message = e.what();
-                                        result.duration_ms = duration;
-                                        try {
-                                            http_events_subj.get_subscriber().on_next(result);
-                                        } catch (...) {
-                                            // Subject may be destroyed, ignore during shutdown
-                                        }
-                                    }
-                                    
-                                    // Still throw to maintain existing error behavior
-                                    throw std::runtime_error(std::string("async_api::insert failed: ") + e.what() + " -> Dropping " + std::to_string(w->size()) + " bytes");
-                                }
-                            }
-                        },
-                        [this](std::exception_ptr ep) {
-                            // Check started before accessing subject
-                            if (!started.load()) {
-                                return;
-                            }
-                            
-                            try { std::rethrow_exception(ep); }
-                            catch (const std::runtime_error& ex) {
-                                // Emit error event for unhandled exceptions
-                                influxdb::api::http_result result(false, "insert", 0);
-                                result.error_message = ex.what();
-                                try {
-                                    http_events_subj.get_subscriber().on_next(result);
-                                } catch (...) {
-                                    // Subject may be destroyed, ignore during shutdown
-                                }
-                                std::cerr << ex.what() << std::endl;
-                            }
-                        });
-                    })
-                ;
+    // The worker for all of lines, or nullptr if they are to be queued one
+    // by one: chained lines that belong to series of different workers, or
+    // that exceed window_max_bytes together, since batches are only split
+    // between queued entries
+    worker* single_worker_for(std::string_view lines)
+    {
+        if (window_max_bytes != 0 && lines.size() > window_max_bytes && find_unquoted(lines, '\n') != lines.size()) {
+            return nullptr;
+        }
+
+        if (workers.size() == 1) {
+            return workers.front().get();
+        }
+
+        worker* target = nullptr;
+        bool mixed = false;
+        for_each_line(lines, [&](std::string_view line) {
+            auto& w = worker_for(line);
+            mixed = mixed || (target != nullptr && target != &w);
+            target = &w;
+        });
+        return mixed ? nullptr : (target ? target : workers.front().get());
+    }
+
+    // lines are queued already formatted, see insert(). Returns whether
+    // all lines were queued; a full queue is handled according to policy.
+    bool push(std::string&& lines, influxdb::api::overflow_policy policy)
+    {
+        if (!started.load()) {
+            return false;
+        }
+
+        if (auto target = single_worker_for(lines)) {
+            return target->push(std::move(lines), policy);
+        }
+
+        bool queued = true;
+        for_each_line(lines, [&](std::string_view line) {
+            queued = worker_for(line).push(std::string(line), policy) && queued;
+        });
+        return queued;
+    }
+
+    // Never waits and never drops. Returns whether all lines were queued;
+    // if not, lines keeps those that were not.
+    bool try_push(std::string& lines)
+    {
+        if (!started.load()) {
+            return false;
+        }
+
+        if (auto target = single_worker_for(lines)) {
+            return target->try_push(std::move(lines));
+        }
+
+        std::string rest;
+        for_each_line(lines, [&](std::string_view line) {
+            std::string single(line);
+            if (!worker_for(line).try_push(std::move(single))) {
+                if (!rest.empty()) {
+                    rest += '\n';
+                }
+                rest += single;
             }
+        });
+        lines = std::move(rest);
+        return lines.empty();
+    }
+
+    std::size_t queue_depth() const
+    {
+        std::size_t depth = 0;
+        for (auto const& w : workers) {
+            depth += w->queue.size();
+        }
+        return depth;
+    }
+
+    std::size_t queue_capacity() const
+    {
+        std::size_t capacity = 0;
+        for (auto const& w : workers) {
+            capacity += w->queue.capacity();
         }
+        return capacity;
+    }
 
     ~impl() {
-        // Proper shutdown sequence:
-        // 1. Stop accepting new operations
+        // 1. Stop accepting new lines
         started = false;
-        
-        // 2. Unsubscribe the listener to stop processing new windows
-        try {
-            if (listener.is_subscribed()) {
-                listener.unsubscribe();
-            }
-        } catch (...) {
-            // Ignore errors during shutdown
-        }
-        
-        // 3. Give a moment for in-flight operations to complete before unsubscribing
-        // This is especially important for the event loop scheduler
-        std::this_thread::sleep_for(std::chrono::milliseconds(200));
-        
-        // 4. Unsubscribe the worker (RxCpp issue #437: workers need explicit unsubscribe)
-        try {
-            shared_worker.unsubscribe();
-        } catch (...) {
-            // Ignore errors during shutdown
+
+        // 2. Let the flushers send what has been queued, all at once,
+        // until the shutdown deadline
+        auto const deadline = shutdown_timeout == std::chrono::milliseconds::zero()
+            ? clock::time_point::max()
+            : clock::now() + shutdown_timeout;
+        for (auto& w : workers) {
+            w->stop(deadline);
+        }
+
+        // 3. Wait for them and for their requests still on the wire
+        for (auto& w : workers) {
+            w->join();
         }
-        
-        // 5. Give one more moment after worker unsubscribe for final cleanup
-        std::this_thread::sleep_for(std::chrono::milliseconds(200));
     }
 };
 
@@ -309,21 +1028,75 @@ void influxdb::async_api::simple_db::drop()
     pimpl->simpledb.drop();
 }
 
-void influxdb::async_api::simple_db::insert(influxdb::api::line const & lines)
+bool influxdb::async_api::simple_db::insert(influxdb::api::line const & lines)
 {
-    auto subscriber = pimpl->subj.get_subscriber();
+    return pimpl->push(lines.get(), pimpl->overflow);
+}
+
+bool influxdb::async_api::simple_db::insert(influxdb::api::line && lines)
+{
+    return pimpl->push(lines.take(), pimpl->overflow);
+}
 
-    if (!subscriber.is_subscribed()) {
-        return;
+bool influxdb::async_api::simple_db::try_insert(influxdb::api::line const & lines)
+{
+    auto formatted = lines.get();
+    return pimpl->try_push(formatted);
+}
+
+bool influxdb::async_api::simple_db::try_insert(influxdb::api::line && lines)
+{
+    auto formatted = lines.take();
+    if (pimpl->try_push(formatted)) {
+        return true;
     }
 
-    subscriber.on_next(lines);
+    // the caller keeps the lines that were not queued
+    lines = influxdb::api::line(std::move(formatted));
+    return false;
+}
+
+std::size_t influxdb::async_api::simple_db::queue_depth() const
+{
+    return pimpl->queue_depth();
+}
+
+std::size_t influxdb::async_api::simple_db::queue_capacity() const
+{
+    return pimpl->queue_capacity();
+}
+
+unsigned long long influxdb::async_api::simple_db::dropped() const
+{
+    return pimpl->dropped.load(std::memory_order_relaxed);
 }
 
+influxdb::api::async_metrics influxdb::async_api::simple_db::metrics() const
+{
+    return pimpl->metrics();
+}
+
+influxdb::utility::spill_stats influxdb::async_api::simple_db::spill_stats() const
+{
+    influxdb::utility::spill_stats total;
+    for (auto const& w : pimpl->workers) {
+        if (w->spill) {
+            total += w->spill->stats();
+        }
+    }
+    return total;
+}
+
+bool influxdb::async_api::simple_db::flush(std::chrono::milliseconds timeout)
+{
+    return pimpl->flush(timeout);
+}
 
 void influxdb::async_api::simple_db::with_authentication(std::string const& username, std::string const& password)
 {
-    pimpl->db.with_authentication(username, password);
+    for (auto& w : pimpl->workers) {
+        w->db->with_authentication(username, password);
+    }
 }
 
 rxcpp::observable<influxdb::api::http_result> influxdb::async_api::simple_db::http_events() const
@@ -331,23 +1104,17 @@ rxcpp::observable<influxdb::api::http_result> influxdb::async_api::simple_db::ht
     return pimpl->http_events_subj.get_observable();
 }
 
-void influxdb::async_api::simple_db::wait_for_submission(std::chrono::milliseconds quiet_period_ms) const
+void influxdb::async_api::simple_db::on_http_event(std::function<void(influxdb::api::http_event const&)> handler, unsigned sample_every)
 {
-    // Use RxCpp debounce to wait until no HTTP events occur for quiet_period_ms
-    // This is a simple reactive approach - no mutexes, no polling
-    // Use current_thread scheduler to avoid creating new threads
-    auto scheduler = rxcpp::observe_on_one_worker(rxcpp::schedulers::make_current_thread());
-    http_events()
-        .start_with(influxdb::api::http_result(true, "wait", 0))
-        .debounce(quiet_period_ms, scheduler)
-        .take(1)
-        .as_blocking()
-        .subscribe(
-            [](const influxdb::api::http_result&) {
-                // Debounce completed - no events for quiet_period_ms, all submissions are done
-            },
-            [](std::exception_ptr) {
-                // Ignore errors during wait
-            }
-        );
+    pimpl->on_http_event(std::move(handler), sample_every);
+}
+
+void influxdb::async_api::simple_db::wait_for_submission() const
+{
+    pimpl->wait_for(pimpl->enqueued(), std::chrono::milliseconds::zero());
+}
+
+bool influxdb::async_api::simple_db::wait_for_submission(std::chrono::milliseconds timeout) const
+{
+    return pimpl->wait_for(pimpl->enqueued(), timeout);
 }
@@ -5,10 +5,15 @@
 
 #pragma once
 
+#include <chrono>
+#include <cstddef>
+#include <functional>
 #include <string>
 #include <memory>
 #include "influxdb_config.h"
 #include "influxdb_http_events.h"
+#include "influxdb_metrics.h"
+#include "spill_queue.h"
 #include <rxcpp/rx.hpp>
 
 namespace influxdb {
@@ -31,17 +36,65 @@ namespace influxdb {
         public:
             void create();
             void drop();
-            void insert(influxdb::api::line const& lines);
+            /// Queues the lines for the next batch. If the queue is full, this
+            /// waits, drops a line or fails according to queue_config::overflow.
+            /// Returns whether the lines were queued.
+            bool insert(influxdb::api::line const& lines);
+            /// as above, moving the formatted lines into the queue without a copy
+            bool insert(influxdb::api::line&& lines);
+
+            /// Queues the lines if there is room, without waiting or dropping
+            /// anything regardless of the overflow policy. A line that was
+            /// not queued is left with the caller.
+            bool try_insert(influxdb::api::line const& lines);
+            bool try_insert(influxdb::api::line&& lines);
+
+            /// number of lines waiting for the batching thread
+            std::size_t queue_depth() const;
+            std::size_t queue_capacity() const;
+
+            /// lines not sent because the queue was full: rejected by
+            /// drop_newest or fail, or discarded by drop_oldest; lines still
+            /// queued past queue_config::shutdown_timeout_ms; and lines that
+            /// did not fit into the spill queue or were refused on replay
+            unsigned long long dropped() const;
+
+            /// Counters and histograms of the pipeline, kept with relaxed
+            /// atomics; cheap enough to poll every second
+            influxdb::api::async_metrics metrics() const;
+
+            /// counters of the spill queues, all zero without db_config::spill
+            influxdb::utility::spill_stats spill_stats() const;
+
+            /// Sends the partial batches now and waits until every line
+            /// inserted before the call is acknowledged, failed or dropped,
+            /// or spilled to disk (see db_config::spill) to be sent later.
+            /// Returns false if that took longer than timeout (0 for no limit).
+            bool flush(std::chrono::milliseconds timeout = std::chrono::milliseconds::zero());
+
             void with_authentication(std::string const& username, std::string const& password);
             
             /// Get observable of HTTP operation results (successes and failures)
             /// Subscribe to this to monitor HTTP requests and handle errors
             rxcpp::observable<influxdb::api::http_result> http_events() const;
+
+            /// Calls handler with the outcome of every request as a plain
+            /// http_event, on the HTTP client's threads, one call at a time.
+            /// With sample_every > 1 only one in that many successful requests
+            /// is reported; failures always are. An empty handler unsubscribes;
+            /// the handler itself must not call on_http_event().
+            /// Without a handler and without subscribers to http_events(),
+            /// no events are built.
+            void on_http_event(std::function<void(influxdb::api::http_event const&)> handler, unsigned sample_every = 1);
             
-            /// Wait for all pending submissions to be sent via HTTP
-            /// Uses RxCpp debounce to wait until no HTTP events occur for the specified duration
-            /// @param quiet_period_ms Maximum time to wait for silence (default: 100ms)
-            void wait_for_submission(std::chrono::milliseconds quiet_period_ms = std::chrono::milliseconds(100)) const;
+            /// Waits until every line inserted before the call has been
+            /// acknowledged, has failed, was dropped or spilled; returns at
+            /// once if nothing is pending. Unlike flush(), batches are sent
+            /// as usual.
+            void wait_for_submission() const;
+            /// as above, for at most timeout (0 for no limit); returns
+            /// whether the lines were resolved before it passed
+            bool wait_for_submission(std::chrono::milliseconds timeout) const;
         };
     }
 
@@ -8,23 +8,20 @@
 
 #include "input_sanitizer.h"
 
-#include <regex>
+#include <stdexcept>
+#include <string>
 
 namespace influxdb {
     namespace utility {
-        constexpr const char* regex = R"((^[a-zA-Z0-9_\-]+$|"(?:[^\\"]|\\.)+"))";
-
-        const std::regex check_identifier(regex);
-
-        bool valid_identifier(std::string const & input)
+        bool valid_identifier(std::string_view input)
         {
-            return std::regex_match(input, check_identifier);
+            return detail::valid_identifier(input.data(), input.size());
         }
 
-        void throw_on_invalid_identifier(std::string const & input)
+        void throw_on_invalid_identifier(std::string_view input)
         {
             if (!valid_identifier(input))
-                throw std::runtime_error(std::string("Invalid identifier: ") + input);
+                throw std::runtime_error(std::string("Invalid identifier: ").append(input));
         }
     }
 
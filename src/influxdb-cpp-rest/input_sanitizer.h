@@ -5,14 +5,70 @@
 
 #pragma once
 
+#include <array>
+#include <cstddef>
 #include <string>
+#include <string_view>
 
 namespace influxdb {
     namespace utility {
 
+        namespace detail {
+
+            // [a-zA-Z0-9_\-]
+            inline constexpr std::array<bool, 256> identifier_chars = [] {
+                std::array<bool, 256> chars{};
+                for (char c = 'a'; c <= 'z'; ++c)
+                    chars[static_cast<unsigned char>(c)] = true;
+                for (char c = 'A'; c <= 'Z'; ++c)
+                    chars[static_cast<unsigned char>(c)] = true;
+                for (char c = '0'; c <= '9'; ++c)
+                    chars[static_cast<unsigned char>(c)] = true;
+                chars['_'] = true;
+                chars['-'] = true;
+                return chars;
+            }();
+
+            // Same language as the ECMAScript regex
+            // (^[a-zA-Z0-9_\-]+$|"(?:[^\\"]|\\.)+") under std::regex_match:
+            // either a plain identifier, or a double-quoted one where quotes
+            // and backslashes only appear escaped and '.' does not match
+            // line terminators.
+            constexpr bool valid_identifier(char const* input, std::size_t size) {
+                if (size == 0)
+                    return false;
+
+                if (input[0] != '"') {
+                    bool valid = true;
+                    for (std::size_t i = 0; i < size; ++i)
+                        valid &= identifier_chars[static_cast<unsigned char>(input[i])];
+                    return valid;
+                }
+
+                const std::size_t last = size - 1;
+                if (size < 3 || input[last] != '"')
+                    return false;
+
+                std::size_t i = 1;
+                while (i < last) {
+                    const char c = input[i];
+                    if (c == '"')
+                        return false;
+                    if (c == '\\') {
+                        if (i + 1 == last || input[i + 1] == '\n' || input[i + 1] == '\r')
+                            return false;
+                        i += 2;
+                    } else {
+                        ++i;
+                    }
+                }
+                return true;
+            }
+        }
+
         //allowing C-like idenifiers for now (no unicode or spaces as in https://docs.influxdata.com/influxdb/v1.0/query_language/spec/#identifiers)
-        bool valid_identifier(std::string const& input);
+        bool valid_identifier(std::string_view input);
 
-        void throw_on_invalid_identifier(std::string const& input);
+        void throw_on_invalid_identifier(std::string_view input);
     }
 }
@@ -0,0 +1,119 @@
+/* * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+namespace influxdb {
+    namespace utility {
+
+        /// Position of the first delimiter in text at or after begin that is
+        /// neither escaped by a backslash nor inside a double-quoted string,
+        /// or text.size() if there is none
+        constexpr std::size_t find_unquoted(std::string_view text, char delimiter, std::size_t begin = 0) {
+            bool quoted = false;
+            for (std::size_t i = begin; i < text.size(); ++i) {
+                char const c = text[i];
+                if (c == '\\') {
+                    ++i;
+                } else if (c == '"') {
+                    quoted = !quoted;
+                } else if (c == delimiter && !quoted) {
+                    return i;
+                }
+            }
+            return text.size();
+        }
+
+        /// The series of a formatted line, "measurement,tag=value,...":
+        /// everything before the first unquoted space
+        constexpr std::string_view series_of(std::string_view line) {
+            return line.substr(0, find_unquoted(line, ' '));
+        }
+
+        /// The key of a "key=value" field; keys escape '=' with a backslash
+        constexpr std::string_view field_key(std::string_view field) {
+            for (std::size_t i = 0; i < field.size(); ++i) {
+                if (field[i] == '\\')
+                    ++i;
+                else if (field[i] == '=')
+                    return field.substr(0, i);
+            }
+            return field;
+        }
+
+        /// A formatted line "series fields timestamp" split at its unquoted
+        /// spaces; fields and timestamp are empty if missing
+        struct line_parts {
+            std::string_view series;
+            std::string_view fields;
+            std::string_view timestamp;
+        };
+
+        constexpr line_parts split_line(std::string_view line) {
+            auto const fields = find_unquoted(line, ' ');
+            if (fields == line.size())
+                return { line, {}, {} };
+            auto const timestamp = find_unquoted(line, ' ', fields + 1);
+            if (timestamp == line.size())
+                return { line.substr(0, fields), line.substr(fields + 1), {} };
+            return { line.substr(0, fields), line.substr(fields + 1, timestamp - fields - 1), line.substr(timestamp + 1) };
+        }
+
+        /// The timestamp of a formatted line, "measurement,tags fields timestamp":
+        /// what follows the second unquoted space, or empty if there is none
+        constexpr std::string_view timestamp_of(std::string_view line) {
+            return split_line(line).timestamp;
+        }
+
+        /// Calls f with each non-empty line of text, in order
+        template <typename F>
+        void for_each_line(std::string_view text, F&& f) {
+            std::size_t begin = 0;
+            while (begin < text.size()) {
+                auto const end = find_unquoted(text, '\n', begin);
+                if (end > begin)
+                    f(text.substr(begin, end - begin));
+                begin = end + 1;
+            }
+        }
+
+        /// Calls f(line, split_line(line)) with each non-empty line of text,
+        /// in order. Lines without quotes or backslashes, the most common,
+        /// are split with plain searches instead of a walk over each character.
+        template <typename F>
+        void for_each_line_parts(std::string_view text, F&& f) {
+            std::size_t begin = 0;
+            while (begin < text.size()) {
+                auto newline = text.find('\n', begin);
+                if (newline == std::string_view::npos)
+                    newline = text.size();
+                auto line = text.substr(begin, newline - begin);
+
+                if (line.find('"') == std::string_view::npos && line.find('\\') == std::string_view::npos) {
+                    if (!line.empty()) {
+                        auto const fields = line.find(' ');
+                        auto const timestamp = fields == std::string_view::npos ? fields : line.find(' ', fields + 1);
+                        if (fields == std::string_view::npos)
+                            f(line, line_parts{ line, {}, {} });
+                        else if (timestamp == std::string_view::npos)
+                            f(line, line_parts{ line.substr(0, fields), line.substr(fields + 1), {} });
+                        else
+                            f(line, line_parts{ line.substr(0, fields), line.substr(fields + 1, timestamp - fields - 1), line.substr(timestamp + 1) });
+                    }
+                    begin = newline + 1;
+                    continue;
+                }
+
+                auto const end = find_unquoted(text, '\n', begin);
+                line = text.substr(begin, end - begin);
+                f(line, split_line(line));
+                begin = end + 1;
+            }
+        }
+    }
+}
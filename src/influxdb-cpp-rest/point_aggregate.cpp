@@ -0,0 +1,443 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+
+#include "point_aggregate.h"
+#include "line_protocol.h"
+#include "format_float.h"
+#include "format_integer.h"
+
+#include <algorithm>
+#include <charconv>
+#include <deque>
+#include <limits>
+#include <locale>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+    // Reads a line protocol float. Up to 15 significant digits and powers
+    // of ten up to 22, as written by most producers, convert exactly with
+    // one multiplication or division; the rest goes through a stream.
+    bool parse_float(std::string_view text, double& value) {
+        static constexpr double powers[] = {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+        };
+
+        bool const negative = !text.empty() && text.front() == '-';
+        std::size_t i = !text.empty() && (text.front() == '-' || text.front() == '+') ? 1 : 0;
+
+        std::uint64_t mantissa = 0;
+        int digits = 0;
+        int exponent = 0;
+        bool any = false;
+        for (; i < text.size() && text[i] >= '0' && text[i] <= '9'; ++i, any = true) {
+            if (mantissa != 0 || text[i] != '0') {
+                mantissa = mantissa * 10 + static_cast<unsigned>(text[i] - '0');
+                ++digits;
+            }
+        }
+        if (i < text.size() && text[i] == '.') {
+            for (++i; i < text.size() && text[i] >= '0' && text[i] <= '9'; ++i, any = true) {
+                if (mantissa != 0 || text[i] != '0') {
+                    mantissa = mantissa * 10 + static_cast<unsigned>(text[i] - '0');
+                    ++digits;
+                }
+                --exponent;
+            }
+        }
+        if (!any)
+            return false;
+
+        if (i < text.size() && (text[i] == 'e' || text[i] == 'E')) {
+            int written = 0;
+            auto const first = text.data() + i + 1 + (i + 1 < text.size() && text[i + 1] == '+');
+            auto const parsed = std::from_chars(first, text.data() + text.size(), written);
+            if (parsed.ec != std::errc() || parsed.ptr == first)
+                return false;
+            i = static_cast<std::size_t>(parsed.ptr - text.data());
+            exponent += written;
+        }
+        if (i != text.size())
+            return false;
+
+        if (digits <= 15 && exponent >= -22 && exponent <= 22) {
+            value = exponent < 0 ? static_cast<double>(mantissa) / powers[-exponent] : static_cast<double>(mantissa) * powers[exponent];
+            value = negative ? -value : value;
+            return true;
+        }
+
+        std::istringstream in{ std::string(text) };
+        in.imbue(std::locale::classic());
+        in >> value;
+        return !in.fail();
+    }
+
+    // Numbers are floats, "<n>i" integers and "<n>u" unsigned integers;
+    // strings and booleans are not
+    bool parse_number(std::string_view text, double& value) {
+        if (text.empty())
+            return false;
+
+        auto const digits = text.substr(0, text.size() - 1);
+        if (text.back() == 'i') {
+            std::int64_t n = 0;
+            auto const parsed = std::from_chars(digits.data(), digits.data() + digits.size(), n);
+            value = static_cast<double>(n);
+            return parsed.ec == std::errc() && parsed.ptr == digits.data() + digits.size();
+        }
+        if (text.back() == 'u') {
+            std::uint64_t n = 0;
+            auto const parsed = std::from_chars(digits.data(), digits.data() + digits.size(), n);
+            value = static_cast<double>(n);
+            return parsed.ec == std::errc() && parsed.ptr == digits.data() + digits.size();
+        }
+        return parse_float(text, value);
+    }
+
+    void append_float(std::string& out, double value) {
+        char buffer[influxdb::utility::max_float_chars];
+        out.append(buffer, influxdb::utility::format_float(value, buffer));
+    }
+}
+
+struct influxdb::utility::point_aggregator::impl {
+    struct field {
+        std::string name;
+        // the value as written, kept for f_last
+        std::string last;
+        double min;
+        double max;
+        double sum;
+        // values that were numbers
+        std::uint64_t count;
+    };
+
+    struct window {
+        // the first used ones belong to the window
+        std::vector<field> fields;
+        std::size_t used = 0;
+        std::int64_t start = 0;
+        // 0 while the window is not open, then it can be reused
+        unsigned points = 0;
+        // see closing
+        std::uint64_t sequence = 0;
+    };
+
+    struct series {
+        std::string key;
+        // usually one open window, more while points of the previous ones
+        // may still arrive within the grace period
+        std::vector<window> windows;
+        // the latest timestamp seen
+        std::int64_t newest = std::numeric_limits<std::int64_t>::min();
+        // the latest start of a window that was sent: points up to it that
+        // have no open window are late
+        bool emitted = false;
+        std::int64_t emitted_start = 0;
+    };
+
+    struct deadline {
+        clock::time_point at;
+        std::uint32_t slot;
+        std::uint32_t window;
+        std::uint64_t sequence;
+    };
+
+    std::int64_t const window_ns;
+    std::int64_t const grace_ns;
+    clock::duration const wait;
+    std::size_t const max_series;
+    std::vector<std::string> const measurements;
+
+    // a deque, so that the keys of the index stay where they are
+    std::deque<series> slots;
+    std::unordered_map<std::string_view, std::uint32_t> index;
+    std::uint64_t sequence = 0;
+    // the open windows in the order they opened, which is the order they
+    // are due in; entries of windows closed early are skipped
+    std::deque<deadline> closing;
+    // windows closed early because a point past their end and the grace
+    // period arrived, formatted and newline-terminated, and their points
+    std::string ready;
+    std::size_t ready_begin = 0;
+    std::deque<unsigned> ready_points;
+    std::uint64_t pending_points = 0;
+
+    explicit impl(api::aggregate_config const& config) :
+        window_ns(std::max<std::int64_t>(std::int64_t(config.window_ms) * 1000000, 1)),
+        grace_ns(std::int64_t(config.grace_ms) * 1000000),
+        wait(std::chrono::milliseconds(std::uint64_t(config.window_ms) + config.grace_ms)),
+        max_series(config.max_series),
+        measurements(config.measurements)
+    {
+    }
+
+    bool aggregated(std::string_view series_key) const
+    {
+        if (measurements.empty())
+            return true;
+
+        auto const measurement = series_key.substr(0, find_unquoted(series_key, ','));
+        return std::find(measurements.begin(), measurements.end(), measurement) != measurements.end();
+    }
+
+    bool add(std::string_view line, clock::time_point now)
+    {
+        line_parts parts;
+        unsigned count = 0;
+        for_each_line_parts(line, [&](std::string_view, line_parts const& p) {
+            parts = p;
+            ++count;
+        });
+        if (count != 1 || parts.fields.empty() || !aggregated(parts.series))
+            return false;
+
+        std::int64_t timestamp = 0;
+        if (parts.timestamp.empty()) {
+            timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+        } else {
+            auto const end = parts.timestamp.data() + parts.timestamp.size();
+            auto const parsed = std::from_chars(parts.timestamp.data(), end, timestamp);
+            if (parsed.ec != std::errc() || parsed.ptr != end)
+                return false;
+        }
+        // rounded down, also before 1970
+        auto const start = timestamp - ((timestamp % window_ns) + window_ns) % window_ns;
+
+        auto found = index.find(parts.series);
+        if (found == index.end()) {
+            // slots are never released: beyond the limit, new series are
+            // sent as they are
+            if (slots.size() >= max_series)
+                return false;
+
+            slots.emplace_back();
+            slots.back().key.assign(parts.series);
+            found = index.emplace(slots.back().key, static_cast<std::uint32_t>(slots.size() - 1)).first;
+        }
+        auto& s = slots[found->second];
+
+        std::size_t w = 0;
+        while (w < s.windows.size() && !(s.windows[w].points > 0 && s.windows[w].start == start)) {
+            ++w;
+        }
+        if (w == s.windows.size()) {
+            // the window was sent already: another line at its start
+            // would overwrite the statistics in InfluxDB
+            if (s.emitted && start <= s.emitted_start)
+                return false;
+
+            w = 0;
+            while (w < s.windows.size() && s.windows[w].points > 0) {
+                ++w;
+            }
+            if (w == s.windows.size()) {
+                s.windows.emplace_back();
+            }
+            auto& opened = s.windows[w];
+            opened.start = start;
+            opened.used = 0;
+            opened.sequence = ++sequence;
+            closing.push_back({ now + wait, found->second, static_cast<std::uint32_t>(w), opened.sequence });
+        }
+        auto& current = s.windows[w];
+
+        std::size_t begin = 0;
+        for (std::size_t n = 0; begin < parts.fields.size(); ++n) {
+            auto const end = find_unquoted(parts.fields, ',', begin);
+            auto const text = parts.fields.substr(begin, end - begin);
+            auto const key = field_key(text);
+            if (key.size() < text.size()) {
+                accumulate(current, n, key, text.substr(key.size() + 1));
+            }
+            begin = end + 1;
+        }
+
+        ++current.points;
+        ++pending_points;
+
+        s.newest = std::max(s.newest, timestamp);
+        close_passed(s);
+        return true;
+    }
+
+    // closes, oldest first, the windows of s that the series' timestamps
+    // have passed by more than the grace period
+    void close_passed(series& s)
+    {
+        for (;;) {
+            window* oldest = nullptr;
+            for (auto& w : s.windows) {
+                if (w.points > 0 && s.newest - w.start >= window_ns + grace_ns && (!oldest || w.start < oldest->start)) {
+                    oldest = &w;
+                }
+            }
+            if (!oldest)
+                return;
+
+            format(s, *oldest, ready);
+            ready += '\n';
+            ready_points.push_back(oldest->points);
+            close(s, *oldest);
+        }
+    }
+
+    static void close(series& s, window& w)
+    {
+        s.emitted_start = s.emitted ? std::max(s.emitted_start, w.start) : w.start;
+        s.emitted = true;
+        w.points = 0;
+    }
+
+    // the fields of a series usually come in the same order every time
+    void accumulate(window& w, std::size_t position, std::string_view name, std::string_view value)
+    {
+        field* f = nullptr;
+        if (position < w.used && w.fields[position].name == name) {
+            f = &w.fields[position];
+        } else {
+            auto const known = std::find_if(w.fields.begin(), w.fields.begin() + w.used,
+                [name](field const& candidate) { return candidate.name == name; });
+            if (known != w.fields.begin() + w.used) {
+                f = &*known;
+            } else {
+                if (w.used == w.fields.size()) {
+                    w.fields.emplace_back();
+                }
+                f = &w.fields[w.used++];
+                f->name.assign(name);
+                f->min = std::numeric_limits<double>::infinity();
+                f->max = -std::numeric_limits<double>::infinity();
+                f->sum = 0;
+                f->count = 0;
+            }
+        }
+
+        f->last.assign(value);
+        double number = 0;
+        if (parse_number(value, number)) {
+            f->min = std::min(f->min, number);
+            f->max = std::max(f->max, number);
+            f->sum += number;
+            ++f->count;
+        }
+    }
+
+    static void format(series const& s, window const& w, std::string& out)
+    {
+        out += s.key;
+        out += ' ';
+        for (std::size_t i = 0; i < w.used; ++i) {
+            auto const& f = w.fields[i];
+            if (i > 0) {
+                out += ',';
+            }
+            if (f.count > 0) {
+                out += f.name;
+                out += "_min=";
+                append_float(out, f.min);
+                out += ',';
+                out += f.name;
+                out += "_max=";
+                append_float(out, f.max);
+                out += ',';
+                out += f.name;
+                out += "_mean=";
+                append_float(out, f.sum / static_cast<double>(f.count));
+                out += ',';
+                out += f.name;
+                out += "_count=";
+                append_integer(out, f.count);
+                out += "i,";
+            }
+            out += f.name;
+            out += "_last=";
+            out += f.last;
+        }
+        out += ' ';
+        append_integer(out, w.start);
+    }
+
+    // drops the entries of windows that were closed early
+    void skip_closed()
+    {
+        while (!closing.empty()) {
+            auto const& w = slots[closing.front().slot].windows[closing.front().window];
+            if (w.points > 0 && w.sequence == closing.front().sequence)
+                return;
+            closing.pop_front();
+        }
+    }
+
+    bool pop(std::string& line, unsigned& points, clock::time_point now, bool all)
+    {
+        if (!ready_points.empty()) {
+            auto const end = find_unquoted(ready, '\n', ready_begin);
+            line.assign(ready, ready_begin, end - ready_begin);
+            ready_begin = end + 1;
+            points = ready_points.front();
+            ready_points.pop_front();
+            if (ready_points.empty()) {
+                ready.clear();
+                ready_begin = 0;
+            }
+            pending_points -= points;
+            return true;
+        }
+
+        skip_closed();
+        if (closing.empty() || (!all && closing.front().at > now))
+            return false;
+
+        auto& s = slots[closing.front().slot];
+        auto& w = s.windows[closing.front().window];
+        closing.pop_front();
+        line.clear();
+        format(s, w, line);
+        points = w.points;
+        close(s, w);
+        pending_points -= points;
+        return true;
+    }
+};
+
+influxdb::utility::point_aggregator::point_aggregator(api::aggregate_config const& config) :
+    pimpl(std::make_unique<impl>(config))
+{
+}
+
+influxdb::utility::point_aggregator::~point_aggregator()
+{
+}
+
+bool influxdb::utility::point_aggregator::add(std::string_view line, clock::time_point now)
+{
+    return pimpl->add(line, now);
+}
+
+bool influxdb::utility::point_aggregator::pop(std::string& line, unsigned& points, clock::time_point now, bool all)
+{
+    return pimpl->pop(line, points, now, all);
+}
+
+influxdb::utility::point_aggregator::clock::time_point influxdb::utility::point_aggregator::next_due() const
+{
+    if (!pimpl->ready_points.empty())
+        return clock::time_point::min();
+
+    pimpl->skip_closed();
+    return pimpl->closing.empty() ? clock::time_point::max() : pimpl->closing.front().at;
+}
+
+std::uint64_t influxdb::utility::point_aggregator::pending() const
+{
+    return pimpl->pending_points;
+}
@@ -0,0 +1,55 @@
+/* * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "influxdb_config.h"
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace influxdb {
+    namespace utility {
+
+        /// The windows of api::aggregate_config. A series keeps one slot
+        /// for as long as the aggregator lives, whose windows and field
+        /// statistics are reused once popped: adding a point allocates nothing
+        /// once its series and fields have been seen. There are at most
+        /// max_series slots. Timestamps are taken
+        /// as nanoseconds; lines without one are stamped on arrival. Not
+        /// thread-safe: one per batching thread.
+        class point_aggregator {
+            struct impl;
+            std::unique_ptr<impl> pimpl;
+
+        public:
+            using clock = std::chrono::steady_clock;
+
+            explicit point_aggregator(api::aggregate_config const& config);
+            ~point_aggregator();
+
+            /// Adds a formatted line to the window of its series and
+            /// timestamp. False if the line is not aggregated: chained
+            /// lines, other measurements, no fields, an unreadable
+            /// timestamp, one of a window that was popped already or a new
+            /// series once max_series are known; it is to be sent as it is.
+            bool add(std::string_view line, clock::time_point now);
+
+            /// Formats the next window that is due by now, or the next open
+            /// one if all, into line; points is the number of lines added
+            /// to it. False if there is none.
+            bool pop(std::string& line, unsigned& points, clock::time_point now, bool all);
+
+            /// When pop() will next have a window, time_point::max() if none is open
+            clock::time_point next_due() const;
+
+            /// Lines added to windows not popped yet
+            std::uint64_t pending() const;
+        };
+    }
+}
@@ -0,0 +1,95 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+
+#include "point_coalesce.h"
+
+#include <algorithm>
+
+std::size_t influxdb::utility::point_coalescer::coalesce(std::string& batch)
+{
+    index.clear();
+    lines.clear();
+    parts.clear();
+    next.clear();
+    last.clear();
+    merged.clear();
+
+    std::size_t duplicates = 0;
+    for_each_line_parts(batch, [&](std::string_view line, line_parts const& p) {
+        auto const i = static_cast<std::uint32_t>(lines.size());
+        lines.push_back(line);
+        parts.push_back(p);
+        next.push_back(none);
+        last.push_back(i);
+        merged.push_back(false);
+
+        if (p.timestamp.empty() || p.fields.empty())
+            return;
+
+        auto const found = index.try_emplace(point{ p.series, p.timestamp }, i);
+        if (found.second)
+            return;
+
+        auto const first = found.first->second;
+        next[last[first]] = i;
+        last[first] = i;
+        merged[i] = true;
+        ++duplicates;
+    });
+
+    if (duplicates == 0)
+        return 0;
+
+    coalesced.clear();
+    coalesced.reserve(batch.size());
+    for (std::uint32_t i = 0; i < lines.size(); ++i) {
+        if (merged[i])
+            continue;
+        if (next[i] == none) {
+            coalesced += lines[i];
+        } else {
+            merge(i);
+        }
+        coalesced += '\n';
+    }
+    batch.swap(coalesced);
+    return duplicates;
+}
+
+void influxdb::utility::point_coalescer::merge(std::uint32_t first)
+{
+    fields.clear();
+    for (auto i = first; i != none; i = next[i]) {
+        auto const text = parts[i].fields;
+        std::size_t begin = 0;
+        while (begin < text.size()) {
+            auto const end = find_unquoted(text, ',', begin);
+            auto const field = text.substr(begin, end - begin);
+            auto const key = field_key(field);
+
+            auto const known = std::find_if(fields.begin(), fields.end(),
+                [key](std::pair<std::string_view, std::string_view> const& f) { return f.first == key; });
+            if (known != fields.end()) {
+                known->second = field;
+            } else {
+                fields.emplace_back(key, field);
+            }
+            begin = end + 1;
+        }
+    }
+
+    coalesced += parts[first].series;
+    coalesced += ' ';
+    for (std::size_t f = 0; f < fields.size(); ++f) {
+        if (f > 0)
+            coalesced += ',';
+        coalesced += fields[f].second;
+    }
+    coalesced += ' ';
+    coalesced += parts[first].timestamp;
+}
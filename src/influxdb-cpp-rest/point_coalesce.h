@@ -0,0 +1,73 @@
+/* * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "line_protocol.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace influxdb {
+    namespace utility {
+
+        /// Merges the lines of a batch that write the same point, i.e. the
+        /// same series and timestamp, into one line, as InfluxDB would merge
+        /// them: a later field replaces an earlier one of the same name, and
+        /// the other fields are kept. The merged line takes the place of the
+        /// first of them. Lines without a timestamp are left alone.
+        ///
+        /// Series and timestamps are compared as written, so differently
+        /// ordered tags make different series here. The hash index and
+        /// the buffers are kept for the next batch. Not thread-safe: one
+        /// per batching thread.
+        class point_coalescer {
+            struct point {
+                std::string_view series;
+                std::string_view timestamp;
+
+                bool operator==(point const& other) const {
+                    return series == other.series && timestamp == other.timestamp;
+                }
+            };
+
+            struct point_hash {
+                std::size_t operator()(point const& p) const {
+                    auto const h = std::hash<std::string_view>();
+                    return h(p.series) ^ (h(p.timestamp) * 0x9e3779b97f4a7c15ull);
+                }
+            };
+
+            static constexpr std::uint32_t none = UINT32_MAX;
+
+            // the first line of each point
+            std::unordered_map<point, std::uint32_t, point_hash> index;
+            std::vector<std::string_view> lines;
+            std::vector<line_parts> parts;
+            // per line: the next line of the same point, or none
+            std::vector<std::uint32_t> next;
+            // per first line: the last line of its point so far
+            std::vector<std::uint32_t> last;
+            // per line: whether it was merged into an earlier one
+            std::vector<bool> merged;
+            // key and "key=value" of the fields of the point being merged
+            std::vector<std::pair<std::string_view, std::string_view>> fields;
+            std::string coalesced;
+
+            void merge(std::uint32_t first);
+
+        public:
+            /// Merges the points written more than once in the
+            /// newline-terminated lines of batch, in place. Returns the
+            /// number of lines merged away.
+            std::size_t coalesce(std::string& batch);
+        };
+    }
+}
@@ -0,0 +1,64 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+
+#include "series_sort.h"
+#include "line_protocol.h"
+
+#include <algorithm>
+#include <charconv>
+#include <functional>
+#include <limits>
+
+namespace {
+    // lines without a timestamp get the server's time, which is usually the latest
+    constexpr std::int64_t no_timestamp = std::numeric_limits<std::int64_t>::max();
+
+    std::int64_t parse_timestamp(std::string_view text) {
+        std::int64_t value = 0;
+        auto const parsed = std::from_chars(text.data(), text.data() + text.size(), value);
+        return parsed.ec == std::errc() && parsed.ptr == text.data() + text.size() ? value : no_timestamp;
+    }
+}
+
+void influxdb::utility::series_sorter::sort(std::string& batch)
+{
+    keys.clear();
+    lines.clear();
+
+    for_each_line_parts(batch, [this](std::string_view line, line_parts const& parts) {
+        keys.push_back({
+            std::hash<std::string_view>()(parts.series),
+            parts.timestamp.empty() ? no_timestamp : parse_timestamp(parts.timestamp),
+            static_cast<std::uint32_t>(lines.size())
+        });
+        lines.push_back(line);
+    });
+
+    // Series are told apart by their hash alone: two that collide would
+    // only be interleaved by timestamp, each still in its own order. The
+    // index makes the order stable.
+    auto const before = [](key const& a, key const& b) {
+        if (a.hash != b.hash)
+            return a.hash < b.hash;
+        if (a.timestamp != b.timestamp)
+            return a.timestamp < b.timestamp;
+        return a.index < b.index;
+    };
+
+    if (std::is_sorted(keys.begin(), keys.end(), before))
+        return;
+    std::sort(keys.begin(), keys.end(), before);
+
+    sorted.clear();
+    sorted.reserve(batch.size());
+    for (auto const& k : keys) {
+        sorted += lines[k.index];
+        sorted += '\n';
+    }
+    batch.swap(sorted);
+}
@@ -0,0 +1,41 @@
+/* * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace influxdb {
+    namespace utility {
+
+        /// Reorders the lines of a batch so that each series' lines are
+        /// adjacent and in timestamp order, which InfluxDB ingests faster.
+        /// Lines of the same series and timestamp, and lines without a
+        /// timestamp, keep their order, so the points written are the same.
+        ///
+        /// The lines stay where they are while small keys referring to them
+        /// are sorted; the keys and the output buffer are kept for the next
+        /// batch. Not thread-safe: one per batching thread.
+        class series_sorter {
+            struct key {
+                std::uint64_t hash;
+                std::int64_t timestamp;
+                std::uint32_t index;
+            };
+
+            std::vector<key> keys;
+            std::vector<std::string_view> lines;
+            std::string sorted;
+
+        public:
+            /// sorts the newline-terminated lines of batch in place
+            void sort(std::string& batch);
+        };
+    }
+}
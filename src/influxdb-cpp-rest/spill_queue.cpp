@@ -0,0 +1,361 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+
+#include "spill_queue.h"
+
+#include <zlib.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+    // "SPL1" while the record waits to be replayed, "SPL0" once consumed;
+    // anything else ends a segment's records
+    constexpr std::uint32_t live_record = 0x314c5053;
+    constexpr std::uint32_t consumed_record = 0x304c5053;
+
+    struct record_header {
+        std::uint32_t magic;
+        std::uint32_t size;
+        std::uint32_t lines;
+        std::uint32_t crc;
+    };
+
+    constexpr std::size_t record_alignment = 8;
+
+    constexpr std::size_t record_bytes(std::size_t payload) {
+        return (sizeof(record_header) + payload + record_alignment - 1) & ~(record_alignment - 1);
+    }
+
+    std::uint32_t checksum(std::uint32_t size, std::uint32_t lines, unsigned char const* payload) {
+        auto crc = crc32_z(0L, Z_NULL, 0);
+        crc = crc32_z(crc, reinterpret_cast<Bytef const*>(&size), sizeof(size));
+        crc = crc32_z(crc, reinterpret_cast<Bytef const*>(&lines), sizeof(lines));
+        crc = crc32_z(crc, payload, size);
+        return static_cast<std::uint32_t>(crc);
+    }
+
+    std::string segment_name(std::uint64_t sequence) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.spill", static_cast<unsigned long long>(sequence));
+        return name;
+    }
+
+    // A segment file mapped into memory
+    class segment {
+        fs::path path;
+        int fd = -1;
+
+    public:
+        unsigned char* data = nullptr;
+        std::size_t size = 0;
+        // where the next record goes
+        std::size_t end = 0;
+        // records not consumed yet
+        std::size_t live = 0;
+
+        segment(fs::path const& file, std::size_t create_size) : path(file) {
+#ifndef _WIN32
+            fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+            if (fd < 0)
+                throw std::runtime_error("spill_queue: could not open " + path.string());
+
+            auto existing = static_cast<std::size_t>(::lseek(fd, 0, SEEK_END));
+            size = existing != 0 ? existing : create_size;
+            if (existing == 0 && ::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+                ::close(fd);
+                throw std::runtime_error("spill_queue: could not size " + path.string());
+            }
+
+            void* mapped = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (mapped == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error("spill_queue: could not map " + path.string());
+            }
+            data = static_cast<unsigned char*>(mapped);
+#else
+            (void)create_size;
+            throw std::runtime_error("spill_queue: memory-mapped segments are not supported on this platform");
+#endif
+        }
+
+        segment(segment const&) = delete;
+        segment& operator=(segment const&) = delete;
+
+        ~segment() {
+#ifndef _WIN32
+            ::munmap(data, size);
+            ::close(fd);
+#endif
+        }
+
+        record_header header(std::size_t offset) const {
+            record_header h;
+            std::memcpy(&h, data + offset, sizeof(h));
+            return h;
+        }
+
+        // asks the kernel to start writing a changed range back
+        void sync(std::size_t offset, std::size_t length) {
+#ifndef _WIN32
+            auto const page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+            auto const start = offset & ~(page - 1);
+            ::msync(data + start, offset + length - start, MS_ASYNC);
+#endif
+        }
+
+        void remove() {
+            std::error_code ignored;
+            fs::remove(path, ignored);
+        }
+    };
+}
+
+influxdb::utility::spill_stats& influxdb::utility::spill_stats::operator+=(spill_stats const& other)
+{
+    spilled_batches += other.spilled_batches;
+    spilled_bytes += other.spilled_bytes;
+    rejected_batches += other.rejected_batches;
+    replayed_batches += other.replayed_batches;
+    replayed_bytes += other.replayed_bytes;
+    replay_time += other.replay_time;
+    pending_batches += other.pending_batches;
+    pending_bytes += other.pending_bytes;
+    segments += other.segments;
+    return *this;
+}
+
+struct influxdb::utility::spill_queue::impl {
+    struct position {
+        segment* file;
+        std::size_t offset;
+    };
+
+    fs::path directory;
+    std::size_t segment_bytes;
+    std::size_t max_segments;
+
+    mutable std::mutex mutex;
+    // oldest first; the last one takes new records
+    std::deque<std::unique_ptr<segment>> segments;
+    std::uint64_t next_sequence = 0;
+    // records not consumed yet, oldest first
+    std::deque<position> records;
+    spill_stats counters;
+
+    impl(std::string const& directory, std::size_t segment_bytes, std::size_t max_bytes) :
+        directory(directory),
+        segment_bytes(std::max<std::size_t>(segment_bytes, record_bytes(0))),
+        max_segments(std::max<std::size_t>(max_bytes / std::max<std::size_t>(segment_bytes, 1), 1))
+    {
+#ifdef _WIN32
+        throw std::runtime_error("spill_queue: memory-mapped segments are not supported on this platform");
+#endif
+        fs::create_directories(this->directory);
+        recover();
+    }
+
+    // maps the segments left by a previous process and collects their records
+    void recover()
+    {
+        std::vector<fs::path> files;
+        for (auto const& entry : fs::directory_iterator(directory)) {
+            if (entry.is_regular_file() && entry.path().extension() == ".spill") {
+                files.push_back(entry.path());
+            }
+        }
+        // the names are fixed-width sequence numbers
+        std::sort(files.begin(), files.end());
+
+        for (auto const& file : files) {
+            auto s = std::make_unique<segment>(file, segment_bytes);
+            scan(*s);
+            next_sequence = std::max<std::uint64_t>(next_sequence, std::stoull(file.stem().string(), nullptr, 16) + 1);
+            segments.push_back(std::move(s));
+        }
+
+        release_consumed();
+    }
+
+    void scan(segment& s)
+    {
+        std::size_t offset = 0;
+        while (offset + sizeof(record_header) <= s.size) {
+            auto const h = s.header(offset);
+            if (h.magic != live_record && h.magic != consumed_record)
+                break;
+            if (record_bytes(h.size) > s.size - offset)
+                break;
+            if (h.magic == live_record) {
+                // a record torn by a crash ends the segment
+                if (checksum(h.size, h.lines, s.data + offset + sizeof(record_header)) != h.crc)
+                    break;
+                records.push_back({ &s, offset });
+                ++s.live;
+                ++counters.pending_batches;
+                counters.pending_bytes += h.size;
+            }
+            offset += record_bytes(h.size);
+        }
+
+        // whatever follows is garbage; clear it so that it cannot pass for a record later
+        if (offset + sizeof(record_header) <= s.size && s.header(offset).magic != 0) {
+            std::memset(s.data + offset, 0, s.size - offset);
+        }
+        s.end = offset;
+    }
+
+    // removes the segments whose records are all consumed, all of them once the queue is empty
+    void release_consumed()
+    {
+        while (!segments.empty() && segments.front()->live == 0 && (segments.size() > 1 || records.empty())) {
+            segments.front()->remove();
+            segments.pop_front();
+        }
+    }
+
+    bool append(std::string_view batch, unsigned lines)
+    {
+        auto const needed = record_bytes(batch.size());
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (needed > segment_bytes || batch.size() > UINT32_MAX) {
+            ++counters.rejected_batches;
+            return false;
+        }
+
+        if (segments.empty() || segments.back()->end + needed > segments.back()->size) {
+            if (segments.size() >= max_segments) {
+                ++counters.rejected_batches;
+                return false;
+            }
+            try {
+                segments.push_back(std::make_unique<segment>(directory / segment_name(next_sequence++), segment_bytes));
+            } catch (std::runtime_error const&) {
+                ++counters.rejected_batches;
+                return false;
+            }
+        }
+
+        auto& s = *segments.back();
+        auto const offset = s.end;
+        auto const payload = s.data + offset + sizeof(record_header);
+        std::memcpy(payload, batch.data(), batch.size());
+
+        record_header h;
+        h.magic = 0;
+        h.size = static_cast<std::uint32_t>(batch.size());
+        h.lines = lines;
+        h.crc = checksum(h.size, h.lines, payload);
+        std::memcpy(s.data + offset, &h, sizeof(h));
+        // the record exists once its magic is written
+        std::memcpy(s.data + offset, &live_record, sizeof(live_record));
+        s.sync(offset, needed);
+
+        s.end += needed;
+        ++s.live;
+        records.push_back({ &s, offset });
+
+        ++counters.spilled_batches;
+        counters.spilled_bytes += batch.size();
+        ++counters.pending_batches;
+        counters.pending_bytes += batch.size();
+        return true;
+    }
+
+    bool front(std::string& batch, unsigned& lines) const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (records.empty())
+            return false;
+
+        auto const& p = records.front();
+        auto const h = p.file->header(p.offset);
+        batch.assign(reinterpret_cast<char const*>(p.file->data + p.offset + sizeof(record_header)), h.size);
+        lines = h.lines;
+        return true;
+    }
+
+    void pop()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (records.empty())
+            return;
+
+        auto const p = records.front();
+        records.pop_front();
+
+        std::memcpy(p.file->data + p.offset, &consumed_record, sizeof(consumed_record));
+        p.file->sync(p.offset, sizeof(consumed_record));
+        --p.file->live;
+
+        --counters.pending_batches;
+        counters.pending_bytes -= p.file->header(p.offset).size;
+        release_consumed();
+    }
+};
+
+influxdb::utility::spill_queue::spill_queue(std::string const& directory, std::size_t segment_bytes, std::size_t max_bytes) :
+    pimpl(std::make_unique<impl>(directory, segment_bytes, max_bytes))
+{
+}
+
+influxdb::utility::spill_queue::~spill_queue()
+{
+}
+
+bool influxdb::utility::spill_queue::append(std::string_view batch, unsigned lines)
+{
+    return pimpl->append(batch, lines);
+}
+
+bool influxdb::utility::spill_queue::front(std::string& batch, unsigned& lines) const
+{
+    return pimpl->front(batch, lines);
+}
+
+void influxdb::utility::spill_queue::pop()
+{
+    pimpl->pop();
+}
+
+bool influxdb::utility::spill_queue::empty() const
+{
+    std::lock_guard<std::mutex> lock(pimpl->mutex);
+    return pimpl->records.empty();
+}
+
+void influxdb::utility::spill_queue::replayed(std::size_t bytes, std::chrono::microseconds duration)
+{
+    std::lock_guard<std::mutex> lock(pimpl->mutex);
+    ++pimpl->counters.replayed_batches;
+    pimpl->counters.replayed_bytes += bytes;
+    pimpl->counters.replay_time += duration;
+}
+
+influxdb::utility::spill_stats influxdb::utility::spill_queue::stats() const
+{
+    std::lock_guard<std::mutex> lock(pimpl->mutex);
+    auto result = pimpl->counters;
+    result.segments = pimpl->segments.size();
+    return result;
+}
@@ -0,0 +1,82 @@
+/* * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace influxdb {
+    namespace utility {
+
+        /// Counters of a spill_queue, or of all of an async_api::simple_db's
+        struct spill_stats {
+            /// batches written to disk, and their bytes
+            std::uint64_t spilled_batches = 0;
+            std::uint64_t spilled_bytes = 0;
+            /// batches not written because the disk budget was used up
+            std::uint64_t rejected_batches = 0;
+            /// batches sent from disk after the server recovered
+            std::uint64_t replayed_batches = 0;
+            std::uint64_t replayed_bytes = 0;
+            /// time spent sending them
+            std::chrono::microseconds replay_time{0};
+            /// batches on disk waiting to be replayed
+            std::uint64_t pending_batches = 0;
+            std::uint64_t pending_bytes = 0;
+            /// segment files in use
+            std::size_t segments = 0;
+
+            double replay_bytes_per_second() const {
+                return replay_time.count() > 0 ? replayed_bytes * 1e6 / replay_time.count() : 0.0;
+            }
+
+            spill_stats& operator+=(spill_stats const& other);
+        };
+
+        /// A persistent FIFO of batches in a directory of fixed-size,
+        /// memory-mapped segment files. Each record carries a CRC-32 and is
+        /// published by writing its header last, so that after a crash the
+        /// queue reopens with every record that was completely written.
+        /// Consumed records are marked in place; a segment file is removed
+        /// once all of its records are consumed. Thread-safe.
+        ///
+        /// Memory mapping is implemented for POSIX systems only; elsewhere
+        /// the constructor throws std::runtime_error.
+        class spill_queue {
+            struct impl;
+            std::unique_ptr<impl> pimpl;
+
+        public:
+            /// Opens or creates the queue in directory, using at most
+            /// max_bytes of disk in segments of segment_bytes each.
+            /// Throws std::runtime_error if the directory is not usable,
+            /// and always on Windows, where segments cannot be mapped yet.
+            spill_queue(std::string const& directory, std::size_t segment_bytes, std::size_t max_bytes);
+            ~spill_queue();
+
+            /// appends a batch of lines; false if it does not fit into the
+            /// disk budget or into a segment
+            bool append(std::string_view batch, unsigned lines);
+
+            /// copies the oldest batch, false if there is none
+            bool front(std::string& batch, unsigned& lines) const;
+
+            /// consumes the oldest batch
+            void pop();
+
+            bool empty() const;
+
+            /// accounts a replayed batch in the statistics
+            void replayed(std::size_t bytes, std::chrono::microseconds duration);
+
+            spill_stats stats() const;
+        };
+    }
+}
@@ -62,6 +62,23 @@ TEST_CASE_METHOD(c_api_test, "config API") {
 
         influx_c_rest_config_set_batch_max_lines(config.get(), 1000);
         influx_c_rest_config_set_batch_max_time_ms(config.get(), 50);
+        influx_c_rest_config_set_batch_max_bytes(config.get(), 1024 * 1024);
+        influx_c_rest_config_set_batch_adaptive(config.get(), 1, 100);
+        influx_c_rest_config_set_batch_sort_by_series(config.get(), 1);
+        influx_c_rest_config_set_batch_coalesce(config.get(), 1);
+    }
+
+    SECTION("set aggregate configuration") {
+        auto config = std::shared_ptr<influx_c_rest_config_t>(
+            influx_c_rest_config_new(),
+            influx_c_rest_config_destroy
+        );
+        REQUIRE(config.get());
+
+        influx_c_rest_config_set_aggregate(config.get(), 1000);
+        influx_c_rest_config_set_aggregate_grace_ms(config.get(), 500);
+        influx_c_rest_config_set_aggregate_max_series(config.get(), 1000);
+        influx_c_rest_config_add_aggregate_measurement(config.get(), "cpu");
     }
 
     SECTION("set http configuration") {
@@ -74,6 +91,8 @@ TEST_CASE_METHOD(c_api_test, "config API") {
         influx_c_rest_config_set_http_keepalive(config.get(), 1);
         influx_c_rest_config_set_http_timeout_ms(config.get(), 5000);
         influx_c_rest_config_set_http_max_connections_per_host(config.get(), 20);
+        influx_c_rest_config_set_http_max_in_flight(config.get(), 4);
+        influx_c_rest_config_set_http_compression(config.get(), 1, 1024, 6);
     }
 
     SECTION("create async db with config") {
@@ -277,7 +296,7 @@ TEST_CASE_METHOD(c_api_test, "async API with lines") {
         REQUIRE(lines.get());
 
         influx_c_rest_async_insert_lines(asyncdb.get(), lines.get());
-        influx_c_rest_async_wait_quiet_ms(asyncdb.get(), 200);
+        CHECK(influx_c_rest_async_wait_quiet_ms(asyncdb.get(), 5000) == 0);
 
         SECTION("query inserted lines") {
             auto res = std::shared_ptr<influx_c_rest_result_vt>(
@@ -312,7 +331,7 @@ TEST_CASE_METHOD(c_api_test, "async API with lines") {
         REQUIRE(lines.get());
 
         influx_c_rest_async_insert_lines_default_timestamp(asyncdb.get(), lines.get());
-        influx_c_rest_async_wait_quiet_ms(asyncdb.get(), 200);
+        CHECK(influx_c_rest_async_wait_quiet_ms(asyncdb.get(), 5000) == 0);
 
         SECTION("query inserted lines") {
             auto res = std::shared_ptr<influx_c_rest_result_vt>(
@@ -355,7 +374,7 @@ TEST_CASE_METHOD(c_api_test, "async API with lines") {
         }
 
         influx_c_rest_async_insert_lines(asyncdb.get(), lines.get());
-        influx_c_rest_async_wait_quiet_ms(asyncdb.get(), 200);
+        CHECK(influx_c_rest_async_wait_quiet_ms(asyncdb.get(), 5000) == 0);
 
         SECTION("query inserted lines") {
             auto res = std::shared_ptr<influx_c_rest_result_vt>(
@@ -414,7 +433,33 @@ TEST_CASE_METHOD(c_api_test, "async API with config") {
         REQUIRE(lines.get());
 
         influx_c_rest_async_insert_lines(db_with_config.get(), lines.get());
-        influx_c_rest_async_wait_quiet_ms(db_with_config.get(), 200);
+        CHECK(influx_c_rest_async_wait_quiet_ms(db_with_config.get(), 5000) == 0);
+    }
+
+    SECTION("non-blocking inserts into a bounded queue") {
+        auto config = std::shared_ptr<influx_c_rest_config_t>(
+            influx_c_rest_config_new(),
+            influx_c_rest_config_destroy
+        );
+        REQUIRE(config.get());
+
+        influx_c_rest_config_set_queue_capacity(config.get(), 1024);
+        influx_c_rest_config_set_queue_overflow(config.get(), INFLUX_C_REST_OVERFLOW_FAIL);
+        influx_c_rest_config_set_queue_workers(config.get(), 2);
+
+        auto db_with_config = std::shared_ptr<influx_c_rest_async_t>(
+            influx_c_rest_async_new_config("http://localhost:8086", "c_api_test_config", config.get()),
+            influx_c_rest_async_destroy
+        );
+        REQUIRE(db_with_config.get());
+
+        CHECK(influx_c_rest_async_try_insert(db_with_config.get(), "queue_test value=1i") == 0);
+        CHECK(influx_c_rest_async_queue_depth(db_with_config.get()) <= 2 * 1024);
+        CHECK(influx_c_rest_async_dropped(db_with_config.get()) == 0);
+        CHECK(influx_c_rest_async_spill_pending_bytes(db_with_config.get()) == 0);
+        influx_c_rest_async_wait(db_with_config.get());
+        CHECK(influx_c_rest_async_flush(db_with_config.get(), 0) == 0);
+        CHECK(influx_c_rest_async_queue_depth(db_with_config.get()) == 0);
     }
 }
 
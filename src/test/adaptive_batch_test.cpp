@@ -0,0 +1,86 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+
+#include <catch2/catch_test_macros.hpp>
+#include "../influxdb-cpp-rest/adaptive_batch.h"
+
+using namespace influxdb::utility;
+using influxdb::api::batch_config;
+using std::chrono::milliseconds;
+
+namespace {
+    batch_config adaptive(unsigned max_lines, unsigned max_time_ms, unsigned target_latency_ms) {
+        batch_config config(max_lines, max_time_ms);
+        config.adaptive.enabled = true;
+        config.adaptive.target_latency_ms = target_latency_ms;
+        config.adaptive.min_lines = 100;
+        config.adaptive.increase_lines = 100;
+        return config;
+    }
+}
+
+TEST_CASE("without adaptive batching the limits are those configured") {
+    adaptive_batch batching(batch_config(1000, 50));
+    CHECK(batching.max_lines() == 1000);
+    CHECK(batching.max_time() == milliseconds(50));
+
+    batching.on_response(batching.generation(), milliseconds(10000), true);
+    CHECK(batching.max_lines() == 1000);
+    CHECK(batching.max_time() == milliseconds(50));
+}
+
+TEST_CASE("adaptive batches grow while requests are fast and stop at the configured limits") {
+    adaptive_batch batching(adaptive(1000, 100, 50));
+    CHECK(batching.max_lines() == 100);
+    CHECK(batching.max_time() == milliseconds(10));
+
+    batching.on_response(batching.generation(), milliseconds(5), false);
+    CHECK(batching.max_lines() == 200);
+    CHECK(batching.max_time() == milliseconds(20));
+
+    for (int i = 0; i < 20; ++i) {
+        batching.on_response(batching.generation(), milliseconds(5), false);
+    }
+    CHECK(batching.max_lines() == 1000);
+    CHECK(batching.max_time() == milliseconds(100));
+}
+
+TEST_CASE("adaptive batches shrink once per round of slow or failed requests") {
+    adaptive_batch batching(adaptive(1000, 100, 50));
+    for (int i = 0; i < 9; ++i) {
+        batching.on_response(batching.generation(), milliseconds(5), false);
+    }
+    REQUIRE(batching.max_lines() == 1000);
+
+    // several batches were on the wire when the server slowed down
+    auto const sent = batching.generation();
+    batching.on_response(sent, milliseconds(200), false);
+    CHECK(batching.max_lines() == 500);
+    batching.on_response(sent, milliseconds(200), false);
+    batching.on_response(sent, milliseconds(5), true);
+    CHECK(batching.max_lines() == 500);
+    CHECK(batching.max_time() == milliseconds(50));
+
+    // a batch sent after the decrease counts again
+    batching.on_response(batching.generation(), milliseconds(5), true);
+    CHECK(batching.max_lines() == 250);
+
+    for (int i = 0; i < 10; ++i) {
+        batching.on_response(batching.generation(), milliseconds(200), false);
+    }
+    CHECK(batching.max_lines() == 100);
+    CHECK(batching.max_time() == milliseconds(10));
+}
+
+TEST_CASE("without a target latency adaptive batches shrink on failures only") {
+    adaptive_batch batching(adaptive(1000, 100, 0));
+    batching.on_response(batching.generation(), milliseconds(10000), false);
+    CHECK(batching.max_lines() == 200);
+    batching.on_response(batching.generation(), milliseconds(1), true);
+    CHECK(batching.max_lines() == 100);
+}
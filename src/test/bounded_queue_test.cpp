@@ -0,0 +1,86 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+
+#include <catch2/catch_test_macros.hpp>
+#include "../influxdb-cpp-rest/bounded_queue.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace influxdb::utility;
+
+TEST_CASE("the queue capacity is a power of two") {
+    CHECK(bounded_queue<int>(0).capacity() == 2);
+    CHECK(bounded_queue<int>(8).capacity() == 8);
+    CHECK(bounded_queue<int>(1000).capacity() == 1024);
+}
+
+TEST_CASE("values leave the queue in the order they entered it") {
+    bounded_queue<std::string> queue(4);
+    std::string value;
+
+    CHECK(queue.empty());
+    CHECK(!queue.try_pop(value));
+
+    for (int round = 0; round < 3; ++round) {
+        for (int i = 0; i < 4; ++i) {
+            REQUIRE(queue.try_push(std::to_string(i)));
+        }
+        CHECK(queue.size() == 4);
+        CHECK(!queue.try_push("full"));
+
+        for (int i = 0; i < 4; ++i) {
+            REQUIRE(queue.try_pop(value));
+            CHECK(value == std::to_string(i));
+        }
+        CHECK(queue.empty());
+    }
+}
+
+TEST_CASE("concurrent producers and consumers pass every value exactly once") {
+    constexpr int producers = 4;
+    constexpr int values_per_producer = 20000;
+
+    bounded_queue<int> queue(64);
+    std::vector<std::atomic<int>> seen(producers * values_per_producer);
+    std::atomic<int> consumed(0);
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&queue, p] {
+            for (int i = 0; i < values_per_producer; ++i) {
+                int value = p * values_per_producer + i;
+                while (!queue.try_push(std::move(value)))
+                    std::this_thread::yield();
+            }
+        });
+    }
+    for (int c = 0; c < 2; ++c) {
+        threads.emplace_back([&] {
+            int value;
+            while (consumed.load() < producers * values_per_producer) {
+                if (queue.try_pop(value)) {
+                    seen[value].fetch_add(1);
+                    consumed.fetch_add(1);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    bool once = true;
+    for (auto const& count : seen)
+        once = once && count.load() == 1;
+    CHECK(once);
+    CHECK(queue.empty());
+}
@@ -0,0 +1,78 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+
+#include <catch2/catch_test_macros.hpp>
+#include "../influxdb-cpp-rest/influxdb_column_batch.h"
+#include "../influxdb-cpp-rest/influxdb_series_cache.h"
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using influxdb::api::column_batch;
+using influxdb::api::key_value_pairs;
+using influxdb::api::line;
+
+namespace {
+    struct fixed_timestamp {
+        std::int64_t stamp;
+        std::int64_t now() const { return stamp; }
+    };
+}
+
+TEST_CASE("column batches match row-by-row lines") {
+    std::vector<double> usage{ 0.5, 0.25, 1e-7 };
+    std::vector<int> cores{ 8, 16, -1 };
+    bool const online[] = { true, false, true };  // std::vector<bool> has no data()
+    std::vector<std::string> const state{ "ok", "degraded", "ok" };
+    std::vector<std::int64_t> const stamps{ 1700000000000000000, 1700000000000000001, 1700000000000000002 };
+    auto const tags = key_value_pairs("host", "server01").add("region", "us-west");
+
+    column_batch batch("cpu", tags);
+    batch.add("usage", usage).add("cores", cores).add("online", online, 3).add("state", state).timestamps(stamps);
+    REQUIRE(batch.size() == 3);
+
+    auto expected = line("cpu", tags,
+        key_value_pairs("usage", usage[0]).add("cores", cores[0]).add("online", online[0]).add("state", state[0]),
+        fixed_timestamp{ stamps[0] });
+    for (std::size_t row = 1; row < 3; ++row) {
+        expected("cpu", tags,
+            key_value_pairs("usage", usage[row]).add("cores", cores[row]).add("online", online[row]).add("state", state[row]),
+            fixed_timestamp{ stamps[row] });
+    }
+
+    CHECK(batch.get() == expected.get());
+}
+
+TEST_CASE("column batches on a series key and without timestamps") {
+    influxdb::api::series_cache cache;
+    std::vector<float> const celsius{ 21.5f, 22.f };
+
+    column_batch batch(cache.get("temperature", key_value_pairs()));
+    batch.add("celsius", celsius);
+
+    CHECK(batch.get() == "temperature celsius=21.5\ntemperature celsius=22");
+
+    std::string res = "previous line";
+    batch.append_to(res);
+    CHECK(res == "previous line\ntemperature celsius=21.5\ntemperature celsius=22");
+}
+
+TEST_CASE("column batches reject inconsistent input") {
+    std::vector<double> const three{ 1, 2, 3 };
+    std::vector<double> const two{ 1, 2 };
+
+    CHECK_THROWS_AS(column_batch("cpu", key_value_pairs()).add("a", three).add("b", two), std::runtime_error);
+    CHECK_THROWS_AS(column_batch("cpu", key_value_pairs()).add("a", three).timestamps(std::vector<long long>{ 1 }), std::runtime_error);
+    CHECK_THROWS_AS(column_batch("cpu", key_value_pairs()).add("in valid", three), std::runtime_error);
+    CHECK_THROWS_AS(column_batch("", key_value_pairs()), std::runtime_error);
+    CHECK_THROWS_AS(column_batch("cpu", key_value_pairs()).get(), std::runtime_error);
+
+    CHECK(column_batch("cpu", key_value_pairs()).add("a", std::vector<int>{}).get().empty());
+}
@@ -0,0 +1,112 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+
+#include <catch2/catch_test_macros.hpp>
+#include "../influxdb-cpp-rest/format_float.h"
+#include "../influxdb-cpp-rest/format_integer.h"
+#include "../influxdb-cpp-rest/influxdb_line.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <string>
+
+using namespace influxdb::utility;
+
+TEST_CASE("floats are formatted with the shortest round-tripping representation") {
+    CHECK(format_float(0.5) == "0.5");
+    CHECK(format_float(0.1) == "0.1");
+    CHECK(format_float(33.01) == "33.01");
+    CHECK(format_float(3.141592653589793) == "3.141592653589793");
+    CHECK(format_float(0.1f) == "0.1");
+    CHECK(format_float(42.0) == "42");
+    CHECK(format_float(-2.5) == "-2.5");
+}
+
+TEST_CASE("float formatting keeps the stream layout for exponents and special values") {
+    CHECK(format_float(100.0) == "1e+02");
+    CHECK(format_float(1e21) == "1e+21");
+    CHECK(format_float(1.5e-7) == "1.5e-07");
+    CHECK(format_float(0.0001) == "0.0001");
+    CHECK(format_float(1e-300) == "1e-300");
+    CHECK(format_float(0.0) == "0");
+    CHECK(format_float(-0.0) == "-0");
+    CHECK(format_float(std::numeric_limits<double>::infinity()) == "inf");
+    CHECK(format_float(-std::numeric_limits<double>::infinity()) == "-inf");
+    CHECK(format_float(std::numeric_limits<double>::max()) == "1.7976931348623157e+308");
+    CHECK(format_float(std::numeric_limits<double>::denorm_min()) == "5e-324");
+}
+
+TEST_CASE("float formatting matches the precision-probing reference") {
+    std::mt19937_64 random(20240229);
+
+    for (int i = 0; i < 20000; ++i) {
+        std::uint64_t bits = random();
+        double d;
+        std::memcpy(&d, &bits, sizeof(d));
+        if (std::isnan(d))
+            continue;
+        REQUIRE(format_float(d) == detail::format_float_probing(d));
+
+        std::uint32_t bits32 = static_cast<std::uint32_t>(bits);
+        float f;
+        std::memcpy(&f, &bits32, sizeof(f));
+        if (std::isnan(f))
+            continue;
+        REQUIRE(format_float(f) == detail::format_float_probing(f));
+    }
+
+    for (int e = -1074; e <= 1023; ++e) {
+        const double power_of_two = std::ldexp(1.0, e);
+        REQUIRE(format_float(power_of_two) == detail::format_float_probing(power_of_two));
+    }
+}
+
+TEST_CASE("float formatting writes into a caller-provided buffer") {
+    char buffer[max_float_chars];
+    char* end = format_float(-1.25e-10, buffer);
+    CHECK(std::string(buffer, end) == "-1.25e-10");
+}
+
+TEST_CASE("integers are formatted in decimal") {
+    auto formatted = [](auto value) {
+        char buffer[max_integer_chars];
+        return std::string(buffer, format_integer(value, buffer));
+    };
+
+    CHECK(formatted(0) == "0");
+    CHECK(formatted(7) == "7");
+    CHECK(formatted(10) == "10");
+    CHECK(formatted(-42) == "-42");
+    CHECK(formatted(1234567890) == "1234567890");
+    CHECK(formatted(std::numeric_limits<std::int64_t>::min()) == "-9223372036854775808");
+    CHECK(formatted(std::numeric_limits<std::int64_t>::max()) == "9223372036854775807");
+    CHECK(formatted(std::numeric_limits<std::uint64_t>::max()) == "18446744073709551615");
+    CHECK(formatted(std::numeric_limits<short>::min()) == "-32768");
+
+    for (std::uint64_t power = 1, i = 0; i < 19; ++i, power *= 10) {
+        CHECK(formatted(power) == std::to_string(power));
+        CHECK(formatted(power - 1) == std::to_string(power - 1));
+    }
+}
+
+TEST_CASE("integer fields and timestamps are appended to lines") {
+    using influxdb::api::key_value_pairs;
+    using influxdb::api::line;
+
+    CHECK(key_value_pairs("i", -17).add("u", 18446744073709551615ull).get() == "i=-17i,u=18446744073709551615i");
+
+    struct fixed_timestamp {
+        std::uint64_t now() const { return 1700000000123456789ull; }
+    };
+
+    CHECK(line("m", key_value_pairs("t", 1), key_value_pairs("f", 2), fixed_timestamp{}).get() == "m,t=1i f=2i 1700000000123456789");
+    CHECK(line(std::string("m f=1i"), fixed_timestamp{}).get() == "m f=1i 1700000000123456789");
+}
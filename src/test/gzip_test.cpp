@@ -0,0 +1,85 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+
+#include <catch2/catch_test_macros.hpp>
+#include "../influxdb-cpp-rest/gzip.h"
+
+#include <zlib.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace influxdb::utility;
+
+namespace {
+    std::string gunzip(std::vector<unsigned char> const& compressed) {
+        z_stream stream{};
+        // 16 + MAX_WBITS: expect a gzip header
+        if (inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK)
+            throw std::runtime_error("inflateInit2 failed");
+
+        std::string res;
+        char buffer[4096];
+        stream.next_in = const_cast<unsigned char*>(compressed.data());
+        stream.avail_in = static_cast<uInt>(compressed.size());
+
+        int status = Z_OK;
+        while (status == Z_OK) {
+            stream.next_out = reinterpret_cast<Bytef*>(buffer);
+            stream.avail_out = sizeof(buffer);
+            status = inflate(&stream, Z_NO_FLUSH);
+            res.append(buffer, sizeof(buffer) - stream.avail_out);
+        }
+        inflateEnd(&stream);
+
+        if (status != Z_STREAM_END)
+            throw std::runtime_error("inflate failed");
+        return res;
+    }
+
+    std::string some_lines(int count) {
+        std::string res;
+        for (int i = 0; i < count; ++i) {
+            res += "cpu,host=server01,region=us-west usage=0.";
+            res += std::to_string(i);
+            res += ",count=";
+            res += std::to_string(i * 3);
+            res += "i 1700000000";
+            res += std::to_string(100000000 + i);
+            res += '\n';
+        }
+        return res;
+    }
+}
+
+TEST_CASE("gzip output is a gzip stream of the input") {
+    auto const lines = some_lines(100);
+    auto const compressed = gzip(lines);
+
+    REQUIRE(compressed.size() > 2);
+    CHECK(compressed[0] == 0x1f);
+    CHECK(compressed[1] == 0x8b);
+    CHECK(compressed.size() < lines.size() / 4);
+    CHECK(gunzip(compressed) == lines);
+}
+
+TEST_CASE("gzip round-trips empty and incompressible input at all levels") {
+    CHECK(gunzip(gzip("")).empty());
+
+    std::string noise;
+    unsigned state = 12345;
+    for (int i = 0; i < 10000; ++i) {
+        state = state * 1103515245 + 12345;
+        noise.push_back(static_cast<char>(state >> 16));
+    }
+
+    for (int level = 0; level <= 10; ++level) {
+        CHECK(gunzip(gzip(noise, level)) == noise);
+    }
+}
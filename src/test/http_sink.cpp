@@ -0,0 +1,276 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+
+#include "http_sink.h"
+
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace {
+#ifdef _WIN32
+    using socket_t = SOCKET;
+
+    void close_socket(socket_t s) {
+        closesocket(s);
+    }
+
+    struct winsock {
+        winsock() {
+            WSADATA data;
+            WSAStartup(MAKEWORD(2, 2), &data);
+        }
+        ~winsock() {
+            WSACleanup();
+        }
+    };
+#else
+    using socket_t = int;
+
+    void close_socket(socket_t s) {
+        close(s);
+    }
+
+    int const SD_BOTH = SHUT_RDWR;
+#endif
+
+    socket_t to_socket(std::intptr_t s) {
+        return static_cast<socket_t>(s);
+    }
+
+    // the value of a header, case-insensitively, or "" if there is none
+    std::string header(std::string const& head, std::string name) {
+        std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        std::string lower(head);
+        std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+        auto const found = lower.find("\r\n" + name + ":");
+        if (found == std::string::npos)
+            return "";
+
+        auto begin = found + name.size() + 3;
+        auto const end = lower.find("\r\n", begin);
+        while (begin < end && lower[begin] == ' ') {
+            ++begin;
+        }
+        return lower.substr(begin, end - begin);
+    }
+
+    char const* reason(int status) {
+        switch (status) {
+        case 200: return "OK";
+        case 204: return "No Content";
+        case 400: return "Bad Request";
+        case 503: return "Service Unavailable";
+        default: return "Status";
+        }
+    }
+}
+
+http_sink::http_sink(std::function<int(std::size_t)> status_for) :
+    status_for(std::move(status_for)),
+    port(0),
+    held(false),
+    stopping(false)
+{
+#ifdef _WIN32
+    static winsock started;
+#endif
+
+    auto const s = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+
+    socklen_t length = sizeof(address);
+    if (bind(s, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(s, 16) != 0 ||
+        getsockname(s, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+        close_socket(s);
+        throw std::runtime_error("http_sink: could not listen on 127.0.0.1");
+    }
+
+    listener = static_cast<std::intptr_t>(s);
+    port = ntohs(address.sin_port);
+    acceptor = std::thread([this] { accept_loop(); });
+}
+
+http_sink::~http_sink()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        held = false;
+        for (auto c : connections) {
+            shutdown(to_socket(c), SD_BOTH);
+        }
+    }
+    changed.notify_all();
+
+    shutdown(to_socket(listener), SD_BOTH);
+    close_socket(to_socket(listener));
+    acceptor.join();
+
+    for (auto& t : threads) {
+        t.join();
+    }
+}
+
+std::string http_sink::url() const
+{
+    return "http://127.0.0.1:" + std::to_string(port);
+}
+
+void http_sink::hold()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    held = true;
+}
+
+void http_sink::release()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        held = false;
+    }
+    changed.notify_all();
+}
+
+std::vector<http_sink::request> http_sink::requests() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return received;
+}
+
+bool http_sink::wait_for_requests(std::size_t count, std::chrono::milliseconds timeout)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    return changed.wait_for(lock, timeout, [&] { return received.size() >= count; });
+}
+
+std::vector<std::string> http_sink::accepted_lines() const
+{
+    std::vector<std::string> lines;
+    std::lock_guard<std::mutex> lock(mutex);
+    for (std::size_t i = 0; i < received.size(); ++i) {
+        if (!answered[i] || received[i].status / 100 != 2)
+            continue;
+
+        auto const& body = received[i].body;
+        std::size_t begin = 0;
+        while (begin < body.size()) {
+            auto end = body.find('\n', begin);
+            if (end == std::string::npos) {
+                end = body.size();
+            }
+            if (end > begin) {
+                lines.push_back(body.substr(begin, end - begin));
+            }
+            begin = end + 1;
+        }
+    }
+    return lines;
+}
+
+void http_sink::accept_loop()
+{
+    for (;;) {
+        auto const c = accept(to_socket(listener), nullptr, nullptr);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping) {
+            if (c != static_cast<socket_t>(-1)) {
+                close_socket(c);
+            }
+            return;
+        }
+        if (c == static_cast<socket_t>(-1)) {
+            continue;
+        }
+
+        connections.push_back(static_cast<std::intptr_t>(c));
+        threads.emplace_back([this, c] { serve(static_cast<std::intptr_t>(c)); });
+    }
+}
+
+void http_sink::serve(std::intptr_t connection)
+{
+    std::string buffer;
+    std::string body;
+    while (read_request(connection, buffer, body)) {
+        std::size_t index;
+        int status;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            index = received.size();
+            status = status_for(index);
+            received.push_back({ std::move(body), status });
+            answered.push_back(false);
+            changed.notify_all();
+
+            changed.wait(lock, [this] { return !held; });
+            if (stopping)
+                break;
+            answered[index] = true;
+        }
+
+        auto const response = "HTTP/1.1 " + std::to_string(status) + " " + reason(status) + "\r\n"
+            "Content-Length: 0\r\n\r\n";
+        if (send(to_socket(connection), response.data(), static_cast<int>(response.size()), 0) != static_cast<int>(response.size()))
+            break;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    connections.erase(std::remove(connections.begin(), connections.end(), connection), connections.end());
+    close_socket(to_socket(connection));
+}
+
+// Reads the next request of the connection into body; what was read past
+// it stays in buffer. False once the connection is closed.
+bool http_sink::read_request(std::intptr_t connection, std::string& buffer, std::string& body)
+{
+    char chunk[4096];
+    auto receive = [&] {
+        auto const n = recv(to_socket(connection), chunk, sizeof(chunk), 0);
+        if (n <= 0)
+            return false;
+        buffer.append(chunk, static_cast<std::size_t>(n));
+        return true;
+    };
+
+    std::size_t head_end;
+    while ((head_end = buffer.find("\r\n\r\n")) == std::string::npos) {
+        if (!receive())
+            return false;
+    }
+
+    auto const head = buffer.substr(0, head_end + 2);
+    auto const length_header = header(head, "content-length");
+    std::size_t const length = length_header.empty() ? 0 : std::stoul(length_header);
+    auto const begin = head_end + 4;
+
+    while (buffer.size() < begin + length) {
+        if (!receive())
+            return false;
+    }
+
+    body = buffer.substr(begin, length);
+    buffer.erase(0, begin + length);
+    return true;
+}
@@ -0,0 +1,70 @@
+/* * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// A minimal HTTP server on 127.0.0.1 standing in for InfluxDB where a test
+// needs to control the responses: it records the body of every request in
+// the order they arrive and answers with the status that status_for() gives
+// for the request's index. While held, requests are recorded but not
+// answered, as by a server that has stalled.
+class http_sink {
+public:
+    struct request {
+        std::string body;
+        int status;
+    };
+
+    explicit http_sink(std::function<int(std::size_t)> status_for = [](std::size_t) { return 204; });
+    ~http_sink();
+
+    http_sink(http_sink const&) = delete;
+    http_sink& operator=(http_sink const&) = delete;
+
+    // e.g. http://127.0.0.1:40123
+    std::string url() const;
+
+    void hold();
+    void release();
+
+    // the requests received so far, answered or not
+    std::vector<request> requests() const;
+
+    // waits until at least count requests were received, at most timeout
+    bool wait_for_requests(std::size_t count, std::chrono::milliseconds timeout = std::chrono::seconds(10));
+
+    // the line protocol lines of all answered requests with a 2xx status
+    std::vector<std::string> accepted_lines() const;
+
+private:
+    void accept_loop();
+    void serve(std::intptr_t connection);
+    bool read_request(std::intptr_t connection, std::string& buffer, std::string& body);
+
+    std::function<int(std::size_t)> status_for;
+    std::intptr_t listener;
+    unsigned short port;
+
+    mutable std::mutex mutex;
+    std::condition_variable changed;
+    bool held;
+    bool stopping;
+    std::vector<request> received;
+    // with the request's index, whether it was answered
+    std::vector<bool> answered;
+    std::vector<std::intptr_t> connections;
+    std::vector<std::thread> threads;
+    std::thread acceptor;
+};
@@ -0,0 +1,74 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+
+#include <catch2/catch_test_macros.hpp>
+#include "../influxdb-cpp-rest/line_protocol.h"
+#include "../influxdb-cpp-rest/influxdb_line.h"
+
+#include <string>
+#include <vector>
+
+using namespace influxdb::utility;
+using influxdb::api::key_value_pairs;
+using influxdb::api::line;
+
+TEST_CASE("the series of a line is everything before its fields") {
+    CHECK(series_of("cpu,host=a value=1i 123") == "cpu,host=a");
+    CHECK(series_of("cpu value=1i") == "cpu");
+    CHECK(series_of("cpu") == "cpu");
+
+    auto formatted = line("cpu", key_value_pairs("host", "server 01"), key_value_pairs("value", 0.5)).get();
+    CHECK(series_of(formatted) == "cpu,host=\"server 01\"");
+
+    CHECK(series_of("cpu\\ load,host=a value=1i") == "cpu\\ load,host=a");
+}
+
+TEST_CASE("the timestamp of a line follows its fields") {
+    CHECK(timestamp_of("cpu,host=a value=1i 123") == "123");
+    CHECK(timestamp_of("cpu,host=a value=1i").empty());
+    CHECK(timestamp_of("cpu").empty());
+    CHECK(timestamp_of("cpu,host=a msg=\"a b c\" -5") == "-5");
+    CHECK(timestamp_of("cpu,host=a msg=\"a b c\"").empty());
+}
+
+TEST_CASE("lines split into series, fields and timestamp with or without quotes") {
+    std::vector<line_parts> parts;
+    for_each_line_parts("cpu,host=a value=1i 10\ncpu msg=\"a b\",x=1i 20\nmem value=2i\nbare\n",
+        [&parts](std::string_view l, line_parts const& p) {
+            CHECK(p.series == split_line(l).series);
+            CHECK(p.fields == split_line(l).fields);
+            CHECK(p.timestamp == split_line(l).timestamp);
+            parts.push_back(p);
+        });
+
+    REQUIRE(parts.size() == 4);
+    CHECK(parts[0].series == "cpu,host=a");
+    CHECK(parts[0].fields == "value=1i");
+    CHECK(parts[0].timestamp == "10");
+    CHECK(parts[1].fields == "msg=\"a b\",x=1i");
+    CHECK(parts[1].timestamp == "20");
+    CHECK(parts[2].fields == "value=2i");
+    CHECK(parts[2].timestamp.empty());
+    CHECK(parts[3].series == "bare");
+    CHECK(parts[3].fields.empty());
+}
+
+TEST_CASE("formatted lines are split at newlines outside quoted strings") {
+    std::vector<std::string> lines;
+    auto collect = [&lines](std::string_view l) { lines.emplace_back(l); };
+
+    for_each_line("a x=1i\nb x=\"two\nlines\"\n\nc x=3i\n", collect);
+    REQUIRE(lines.size() == 3);
+    CHECK(lines[0] == "a x=1i");
+    CHECK(lines[1] == "b x=\"two\nlines\"");
+    CHECK(lines[2] == "c x=3i");
+
+    lines.clear();
+    for_each_line("", collect);
+    CHECK(lines.empty());
+}
@@ -0,0 +1,69 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+
+#include <catch2/catch_test_macros.hpp>
+#include "../influxdb-cpp-rest/influxdb_metrics.h"
+
+#include <cstdint>
+#include <limits>
+#include <thread>
+#include <vector>
+
+using influxdb::api::histogram;
+
+TEST_CASE("histogram buckets cover every value once") {
+    std::vector<std::uint64_t> const values = { 0, 1, 15, 16, 17, 31, 32, 1000, 123456789,
+                                                std::numeric_limits<std::uint64_t>::max() };
+    for (auto value : values) {
+        auto const bucket = histogram::bucket_of(value);
+        REQUIRE(bucket < histogram::bucket_count);
+        CHECK(histogram::lowest_in(bucket) <= value);
+        CHECK(value <= histogram::highest_in(bucket));
+    }
+
+    for (std::size_t bucket = 1; bucket < histogram::bucket_count; ++bucket) {
+        CHECK(histogram::lowest_in(bucket) == histogram::highest_in(bucket - 1) + 1);
+    }
+}
+
+TEST_CASE("histogram percentiles are within 1/16 of the exact value") {
+    histogram h;
+    for (std::uint64_t value = 1; value <= 100000; ++value) {
+        h.record(value);
+    }
+
+    auto const snapshot = h.snapshot();
+    CHECK(snapshot.count() == 100000);
+    CHECK(snapshot.max() == 100000);
+    CHECK(snapshot.mean() == 50000.5);
+
+    for (double fraction : { 0.5, 0.9, 0.99, 0.999 }) {
+        auto const exact = fraction * 100000;
+        auto const estimate = static_cast<double>(snapshot.percentile(fraction));
+        CHECK(estimate >= exact);
+        CHECK(estimate <= exact * (1 + 1.0 / histogram::sub_buckets));
+    }
+    CHECK(snapshot.percentile(1.0) == 100000);
+    CHECK(histogram().snapshot().percentile(0.5) == 0);
+}
+
+TEST_CASE("histograms can be recorded from several threads") {
+    histogram h;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&h] {
+            for (std::uint64_t value = 0; value < 10000; ++value)
+                h.record(value);
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    CHECK(h.snapshot().count() == 40000);
+    CHECK(h.snapshot().max() == 9999);
+}
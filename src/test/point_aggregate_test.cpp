@@ -0,0 +1,141 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+
+#include <catch2/catch_test_macros.hpp>
+#include "../influxdb-cpp-rest/point_aggregate.h"
+
+#include <chrono>
+#include <string>
+
+using namespace influxdb::utility;
+using clock_type = point_aggregator::clock;
+
+TEST_CASE("points of a window become one line of statistics") {
+    point_aggregator aggregator(influxdb::api::aggregate_config(1000));
+    auto const now = clock_type::now();
+
+    CHECK(aggregator.add("cpu,host=a value=1.5,state=\"idle\" 1000000000", now));
+    CHECK(aggregator.add("cpu,host=a value=4i,state=\"busy\" 1200000000", now));
+    CHECK(aggregator.add("cpu,host=a value=-0.5 1999999999", now));
+    CHECK(aggregator.pending() == 3);
+
+    std::string line;
+    unsigned points = 0;
+    CHECK(!aggregator.pop(line, points, now, false));
+    CHECK(aggregator.next_due() == now + std::chrono::seconds(1));
+
+    REQUIRE(aggregator.pop(line, points, now + std::chrono::seconds(1), false));
+    CHECK(points == 3);
+    CHECK(line == "cpu,host=a value_min=-0.5,value_max=4,value_mean=1.6666666666666667,value_count=3i,value_last=-0.5,"
+        "state_last=\"busy\" 1000000000");
+    CHECK(aggregator.pending() == 0);
+    CHECK(aggregator.next_due() == clock_type::time_point::max());
+}
+
+TEST_CASE("a later window closes the open one of its series") {
+    point_aggregator aggregator(influxdb::api::aggregate_config(10));
+    auto const now = clock_type::now();
+
+    CHECK(aggregator.add("cpu,host=a value=1 5000000", now));
+    CHECK(aggregator.add("cpu,host=b value=2 5000000", now));
+    CHECK(aggregator.add("cpu,host=a value=3 12000000", now));
+
+    std::string line;
+    unsigned points = 0;
+    REQUIRE(aggregator.pop(line, points, now, false));
+    CHECK(points == 1);
+    CHECK(line == "cpu,host=a value_min=1,value_max=1,value_mean=1,value_count=1i,value_last=1 0");
+    CHECK(!aggregator.pop(line, points, now, false));
+
+    // the rest on flush, in the order the windows opened
+    REQUIRE(aggregator.pop(line, points, now, true));
+    CHECK(line == "cpu,host=b value_min=2,value_max=2,value_mean=2,value_count=1i,value_last=2 0");
+    REQUIRE(aggregator.pop(line, points, now, true));
+    CHECK(line == "cpu,host=a value_min=3,value_max=3,value_mean=3,value_count=1i,value_last=3 10000000");
+    CHECK(!aggregator.pop(line, points, now, true));
+}
+
+TEST_CASE("points out of order join their window within the grace period") {
+    influxdb::api::aggregate_config config(10);
+    config.grace_ms = 5;
+    point_aggregator aggregator(config);
+    auto const now = clock_type::now();
+
+    CHECK(aggregator.add("cpu,host=a value=1 5000000", now));
+    CHECK(aggregator.add("cpu,host=a value=2 12000000", now));
+    CHECK(aggregator.add("cpu,host=a value=3 8000000", now));
+    CHECK(aggregator.next_due() == now + std::chrono::milliseconds(15));
+
+    std::string line;
+    unsigned points = 0;
+    CHECK(!aggregator.pop(line, points, now, false));
+
+    // 15 ms is past the end of the first window and its grace period
+    CHECK(aggregator.add("cpu,host=a value=4 15000000", now));
+    REQUIRE(aggregator.pop(line, points, now, false));
+    CHECK(points == 2);
+    CHECK(line == "cpu,host=a value_min=1,value_max=3,value_mean=2,value_count=2i,value_last=3 0");
+    CHECK(!aggregator.pop(line, points, now, false));
+    CHECK(aggregator.pending() == 2);
+}
+
+TEST_CASE("late points of a window that was sent are not aggregated again") {
+    point_aggregator aggregator(influxdb::api::aggregate_config(10));
+    auto const now = clock_type::now();
+
+    CHECK(aggregator.add("cpu,host=a value=1 5000000", now));
+    CHECK(aggregator.add("cpu,host=a value=2 12000000", now));
+
+    std::string line;
+    unsigned points = 0;
+    REQUIRE(aggregator.pop(line, points, now, false));
+    CHECK(line == "cpu,host=a value_min=1,value_max=1,value_mean=1,value_count=1i,value_last=1 0");
+
+    // another line at 0 would overwrite the one sent
+    CHECK(!aggregator.add("cpu,host=a value=3 7000000", now));
+    CHECK(aggregator.add("cpu,host=b value=3 7000000", now));
+    CHECK(aggregator.pending() == 2);
+
+    // the same once the wall clock closed the window
+    REQUIRE(aggregator.pop(line, points, now + std::chrono::milliseconds(10), false));
+    CHECK(line == "cpu,host=a value_min=2,value_max=2,value_mean=2,value_count=1i,value_last=2 10000000");
+    CHECK(!aggregator.add("cpu,host=a value=4 19000000", now));
+    CHECK(aggregator.add("cpu,host=a value=5 20000000", now));
+}
+
+TEST_CASE("series beyond max_series are not aggregated") {
+    influxdb::api::aggregate_config config(1000);
+    config.max_series = 2;
+    point_aggregator aggregator(config);
+    auto const now = clock_type::now();
+
+    CHECK(aggregator.add("cpu,host=a value=1 1", now));
+    CHECK(aggregator.add("cpu,host=b value=1 1", now));
+    CHECK(!aggregator.add("cpu,host=c value=1 1", now));
+
+    // known series still are, also once their windows were popped
+    std::string line;
+    unsigned points = 0;
+    while (aggregator.pop(line, points, now, true)) {
+    }
+    CHECK(aggregator.add("cpu,host=a value=2 1000000000", now));
+    CHECK(!aggregator.add("cpu,host=c value=2 1000000000", now));
+    CHECK(aggregator.pending() == 1);
+}
+
+TEST_CASE("lines of other measurements and chained lines are not aggregated") {
+    point_aggregator aggregator(influxdb::api::aggregate_config(1000, { "cpu" }));
+    auto const now = clock_type::now();
+
+    CHECK(aggregator.add("cpu value=1", now));
+    CHECK(!aggregator.add("mem value=1 1", now));
+    CHECK(!aggregator.add("cpu value=1 1\ncpu value=2 2", now));
+    CHECK(!aggregator.add("cpu value=1 soon", now));
+    CHECK(!aggregator.add("cpu", now));
+    CHECK(aggregator.pending() == 1);
+}
@@ -0,0 +1,58 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+
+#include <catch2/catch_test_macros.hpp>
+#include "../influxdb-cpp-rest/point_coalesce.h"
+
+#include <string>
+
+using namespace influxdb::utility;
+
+TEST_CASE("lines writing the same point are merged into the first one") {
+    std::string batch =
+        "cpu,host=a value=1i,idle=5i 10\n"
+        "cpu,host=b value=2i 10\n"
+        "cpu,host=a value=3i 10\n"
+        "cpu,host=a value=4i 20\n"
+        "cpu,host=a user=7i,value=6i 10\n";
+
+    point_coalescer coalescer;
+    CHECK(coalescer.coalesce(batch) == 2);
+    CHECK(batch ==
+        "cpu,host=a value=6i,idle=5i,user=7i 10\n"
+        "cpu,host=b value=2i 10\n"
+        "cpu,host=a value=4i 20\n");
+}
+
+TEST_CASE("lines without a timestamp are not merged") {
+    std::string batch =
+        "cpu value=1i\n"
+        "cpu value=2i\n"
+        "cpu value=3i 10\n";
+    auto const original = batch;
+
+    point_coalescer coalescer;
+    CHECK(coalescer.coalesce(batch) == 0);
+    CHECK(batch == original);
+}
+
+TEST_CASE("quoted and escaped fields are merged by their keys") {
+    std::string batch =
+        "cpu msg=\"a,b=c\",x\\=y=1i 10\n"
+        "cpu msg=\"d e\" 10\n"
+        "cpu x\\=y=2i 10\n";
+
+    point_coalescer coalescer;
+    CHECK(coalescer.coalesce(batch) == 2);
+    CHECK(batch == "cpu msg=\"d e\",x\\=y=2i 10\n");
+
+    // the coalescer is reused for the next batch
+    std::string next = "mem value=1i 1\nmem value=2i 1\n";
+    CHECK(coalescer.coalesce(next) == 1);
+    CHECK(next == "mem value=2i 1\n");
+}
@@ -0,0 +1,55 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+
+#include <catch2/catch_test_macros.hpp>
+#include "../influxdb-cpp-rest/influxdb_raw_request.h"
+
+using namespace influxdb::raw;
+using namespace web::http;
+
+TEST_CASE("the authorization header is computed from the credentials") {
+    CHECK(basic_authorization("admin", "password") == U("Basic YWRtaW46cGFzc3dvcmQ="));
+    CHECK(basic_authorization("", "password").empty());
+}
+
+TEST_CASE("insert requests are built from the write template") {
+    auto const writes = write_template(web::uri(U("http://localhost:8086")), U("my db"), basic_authorization("admin", "password"));
+
+    CHECK(writes.target.to_string() == U("http://localhost:8086/write?db=my%20db"));
+
+    auto request = writes.insert("cpu value=1i");
+    CHECK(request.method() == methods::POST);
+    CHECK(request.request_uri() == writes.target);
+    CHECK(request.headers()[header_names::authorization] == U("Basic YWRtaW46cGFzc3dvcmQ="));
+    CHECK(request.headers().content_length() == 12);
+    CHECK(request.extract_utf8string(true).get() == "cpu value=1i");
+    CHECK(!request.headers().has(header_names::content_encoding));
+}
+
+TEST_CASE("insert requests are gzipped from the threshold on") {
+    auto const writes = write_template(web::uri(U("http://localhost:8086")), U("db"), utility::string_t());
+    influxdb::api::compression_config const compression(true, 12);
+
+    auto small = writes.insert("cpu value=1", compression);
+    CHECK(!small.headers().has(header_names::content_encoding));
+    CHECK(!small.headers().has(header_names::authorization));
+
+    auto large = writes.insert("cpu value=1i", compression);
+    CHECK(large.headers()[header_names::content_encoding] == U("gzip"));
+}
+
+TEST_CASE("query requests carry the encoded statement") {
+    auto const queries = query_template(utility::string_t());
+
+    auto request = queries.query(U("select * from \"m\" where a='b&c'"));
+    CHECK(request.method() == methods::POST);
+    CHECK(request.request_uri().path() == U("/query"));
+    auto const query = web::uri::split_query(request.request_uri().query());
+    REQUIRE(query.count(U("q")) == 1);
+    CHECK(web::uri::decode(query.at(U("q"))) == U("select * from \"m\" where a='b&c'"));
+}
@@ -9,6 +9,10 @@
 #include <catch2/catch_test_macros.hpp>
 #include "../influxdb-cpp-rest/input_sanitizer.h"
 
+#include <regex>
+#include <string>
+#include <string_view>
+
 using namespace influxdb::utility;
 
 TEST_CASE("spaces are not allowed") {
@@ -39,4 +43,38 @@ TEST_CASE("quoted identifiers must begin and end in double quotes") {
     CHECK(!valid_identifier("blup\"bla\""));
     CHECK(!valid_identifier("\"bla\"blup"));
     CHECK(!valid_identifier("\"bla\" "));
-}
\ No newline at end of file
+}
+
+TEST_CASE("the identifier scanner accepts exactly what the original regex accepts") {
+    const std::regex reference(R"((^[a-zA-Z0-9_\-]+$|"(?:[^\\"]|\\.)+"))");
+    const std::string alphabet("aZ0_-\"\\ \n\r\0\xc3.", 13);
+
+    // every string of up to 5 characters over the alphabet
+    std::string input;
+    auto check_all = [&](auto& self, std::size_t length) -> void {
+        REQUIRE(valid_identifier(input) == std::regex_match(input, reference));
+        if (length == 0)
+            return;
+        for (char c : alphabet) {
+            input.push_back(c);
+            self(self, length - 1);
+            input.pop_back();
+        }
+    };
+    check_all(check_all, 5);
+}
+
+TEST_CASE("identifiers can be validated at compile time") {
+    static_assert(detail::valid_identifier("cpu", 3));
+    static_assert(!detail::valid_identifier("cpu load", 8));
+    static_assert(detail::valid_identifier("\"cpu load\"", 10));
+}
+
+TEST_CASE("identifiers are validated without owning their characters") {
+    std::string_view const keys = "cpu load";
+
+    CHECK(valid_identifier(keys.substr(0, 3)));
+    CHECK(valid_identifier(keys.substr(4)));
+    CHECK(!valid_identifier(keys));
+    CHECK_THROWS(throw_on_invalid_identifier(keys.substr(3, 2)));
+}
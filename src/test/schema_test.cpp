@@ -0,0 +1,44 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+
+#include <catch2/catch_test_macros.hpp>
+#include "../influxdb-cpp-rest/influxdb_schema.h"
+
+#include <string>
+
+using influxdb::api::key_value_pairs;
+using influxdb::api::line;
+namespace schema = influxdb::api::schema;
+
+using cpu = schema::measurement<"cpu", schema::tags<"host", "region">, schema::fields<"usage", "idle", "cores">>;
+
+TEST_CASE("schema skeletons are laid out at compile time") {
+    static_assert(cpu::skeleton_text() == "cpu,host=,region= usage=,idle=,cores=");
+    static_assert(schema::measurement<"m", schema::tags<>, schema::fields<"f">>::skeleton_text() == "m f=");
+}
+
+TEST_CASE("schema lines match dynamically built lines") {
+    auto expected = line("cpu",
+        key_value_pairs("host", "server01").add("region", "us-west"),
+        key_value_pairs("usage", 0.64).add("idle", 0.36).add("cores", 8)
+    );
+
+    CHECK(cpu::line("server01", "us-west", 0.64, 0.36, 8).get() == expected.get());
+    CHECK(cpu::line(std::string("server01"), std::string_view("us-west"), 0.64, 0.36, 8).get() == expected.get());
+}
+
+TEST_CASE("schema lines without tags and with timestamps") {
+    struct fixed_timestamp {
+        long long now() const { return 1700000000000000000LL; }
+    };
+
+    using temperature = schema::measurement<"temperature", schema::tags<>, schema::fields<"celsius", "valid">>;
+
+    CHECK(temperature::line(21.5, true).get() == "temperature celsius=21.5,valid=true");
+    CHECK(temperature::line(21.5, true, fixed_timestamp{}).get() == "temperature celsius=21.5,valid=true 1700000000000000000");
+}
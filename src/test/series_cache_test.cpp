@@ -0,0 +1,100 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+
+#include <catch2/catch_test_macros.hpp>
+#include "../influxdb-cpp-rest/influxdb_series_cache.h"
+
+#include <stdexcept>
+#include <string>
+
+using influxdb::api::key_value_pairs;
+using influxdb::api::line;
+using influxdb::api::series_cache;
+
+TEST_CASE("cached series lines match dynamically built lines") {
+    series_cache cache;
+    auto const tags = key_value_pairs("host", "server01").add("region", "us-west");
+    auto const values = key_value_pairs("usage", 0.64).add("cores", 8);
+
+    auto series = cache.get("cpu", tags);
+    CHECK(series.get() == "cpu,host=\"server01\",region=\"us-west\"");
+    CHECK(line(series, values).get() == line("cpu", tags, values).get());
+
+    struct fixed_timestamp {
+        long long now() const { return 1700000000000000000LL; }
+    };
+    CHECK(line(series, values, fixed_timestamp()).get() ==
+        line("cpu", tags, values, fixed_timestamp()).get());
+
+    auto untagged = cache.get("cpu", key_value_pairs());
+    CHECK(untagged.get() == "cpu");
+    CHECK(line(untagged, values).get() == line("cpu", key_value_pairs(), values).get());
+
+    auto multiple = line(series, key_value_pairs("v", 1))(untagged, key_value_pairs("v", 2));
+    CHECK(multiple.get() == line("cpu", tags, key_value_pairs("v", 1))("cpu", key_value_pairs(), key_value_pairs("v", 2)).get());
+}
+
+TEST_CASE("series cache counts hits and misses") {
+    series_cache cache;
+    auto const tags = key_value_pairs("host", "a");
+
+    auto first = cache.get("cpu", tags);
+    auto second = cache.get("cpu", tags);
+    cache.get("cpu", key_value_pairs("host", "b"));
+    cache.get("mem", tags);
+
+    CHECK(first.get() == second.get());
+    CHECK(cache.hits() == 1);
+    CHECK(cache.misses() == 3);
+    CHECK(cache.size() == 3);
+    CHECK(cache.evictions() == 0);
+}
+
+TEST_CASE("series cache evicts the least recently used key") {
+    series_cache cache(2);
+    REQUIRE(cache.capacity() == 2);
+
+    auto a = cache.get("a", key_value_pairs());
+    cache.get("b", key_value_pairs());
+    cache.get("a", key_value_pairs());   // a is now more recent than b
+    cache.get("c", key_value_pairs());   // evicts b
+
+    CHECK(cache.size() == 2);
+    CHECK(cache.evictions() == 1);
+
+    auto const misses = cache.misses();
+    cache.get("a", key_value_pairs());
+    CHECK(cache.misses() == misses);
+    cache.get("b", key_value_pairs());
+    CHECK(cache.misses() == misses + 1);
+
+    cache.clear();
+    CHECK(cache.size() == 0);
+    // handed out keys outlive their eviction
+    CHECK(a.get() == "a");
+}
+
+TEST_CASE("series cache validates the measurement") {
+    series_cache cache;
+
+    CHECK_THROWS_AS(cache.get("", key_value_pairs()), std::runtime_error);
+    CHECK_THROWS_AS(cache.get("a\nb", key_value_pairs()), std::runtime_error);
+    CHECK(cache.size() == 0);
+}
+
+TEST_CASE("series cache validates the measurement of a cached series") {
+    series_cache cache;
+
+    key_value_pairs const tags("host", 1);
+    cache.get("cpu", tags);
+
+    // as a measurement with no tags, "cpu,host=1i" would hit the key cached above
+    auto const clash = "cpu," + std::string(tags.view());
+    CHECK_THROWS_AS(cache.get(clash, key_value_pairs()), std::runtime_error);
+    CHECK(cache.hits() == 0);
+}
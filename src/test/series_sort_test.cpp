@@ -0,0 +1,92 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+
+#include <catch2/catch_test_macros.hpp>
+#include "../influxdb-cpp-rest/series_sort.h"
+#include "../influxdb-cpp-rest/line_protocol.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace influxdb::utility;
+
+namespace {
+    std::vector<std::string> lines_of(std::string const& batch) {
+        std::vector<std::string> lines;
+        for_each_line(batch, [&lines](std::string_view l) { lines.emplace_back(l); });
+        return lines;
+    }
+}
+
+TEST_CASE("sorted batches group the lines of each series in timestamp order") {
+    std::string batch =
+        "cpu,host=b value=1i 30\n"
+        "cpu,host=a value=2i 20\n"
+        "mem,host=a value=3i 10\n"
+        "cpu,host=a value=4i 10\n"
+        "cpu,host=b value=5i 10\n"
+        "cpu,host=a value=6i 30\n";
+    auto const size = batch.size();
+
+    series_sorter sorter;
+    sorter.sort(batch);
+
+    CHECK(batch.size() == size);
+    auto const lines = lines_of(batch);
+    REQUIRE(lines.size() == 6);
+
+    std::map<std::string_view, std::vector<std::string_view>> seen;
+    std::string_view previous;
+    for (auto const& l : lines) {
+        auto const series = series_of(l);
+        // a series does not reappear once another one started
+        if (series != previous) {
+            CHECK(seen.find(series) == seen.end());
+        }
+        seen[series].push_back(timestamp_of(l));
+        previous = series;
+    }
+
+    CHECK(seen["cpu,host=a"] == std::vector<std::string_view>{ "10", "20", "30" });
+    CHECK(seen["cpu,host=b"] == std::vector<std::string_view>{ "10", "30" });
+    CHECK(seen["mem,host=a"] == std::vector<std::string_view>{ "10" });
+}
+
+TEST_CASE("sorting keeps the order of points that overwrite each other") {
+    std::string batch =
+        "cpu,host=a value=1i 10\n"
+        "mem,host=a value=2i\n"
+        "cpu,host=a value=3i 10\n"
+        "mem,host=a value=4i\n"
+        "cpu,host=a msg=\"x\ny\" 5\n";
+
+    series_sorter sorter;
+    sorter.sort(batch);
+
+    auto const lines = lines_of(batch);
+    REQUIRE(lines.size() == 5);
+
+    std::vector<std::string> cpu, mem;
+    for (auto const& l : lines) {
+        (series_of(l) == "cpu,host=a" ? cpu : mem).push_back(l);
+    }
+    CHECK(cpu == std::vector<std::string>{ "cpu,host=a msg=\"x\ny\" 5", "cpu,host=a value=1i 10", "cpu,host=a value=3i 10" });
+    CHECK(mem == std::vector<std::string>{ "mem,host=a value=2i", "mem,host=a value=4i" });
+}
+
+TEST_CASE("a sorted batch is left as it is") {
+    std::string batch = "cpu value=1i 1\n";
+    series_sorter sorter;
+    sorter.sort(batch);
+    CHECK(batch == "cpu value=1i 1\n");
+
+    std::string empty;
+    sorter.sort(empty);
+    CHECK(empty.empty());
+}
@@ -16,12 +16,17 @@
 #include <rxcpp/rx.hpp>
 
 #include "fixtures.h"
+#include "http_sink.h"
 
 #include <chrono>
 #include <thread>
+#include <filesystem>
+#include <vector>
 #include <iostream>
 #include <atomic>
 #include <iomanip>
+#include <algorithm>
+#include <cctype>
 
 using influxdb::api::simple_db;
 using influxdb::api::key_value_pairs;
@@ -119,6 +124,35 @@ TEST_CASE("adding a timestamp to a line") {
 }
 
 
+TEST_CASE("formatted lines can be viewed and moved out") {
+    auto kvp = key_value_pairs("a", 1).add("b", "a longer string value, beyond small strings");
+    auto const formatted = kvp.get();
+    CHECK(kvp.view() == formatted);
+    CHECK(kvp.take() == formatted);
+    CHECK(kvp.empty());
+
+    auto l = line("test", key_value_pairs("t", "v"), key_value_pairs("kvp1", 42));
+    auto const expected = l.get();
+    CHECK(l.view() == expected);
+    CHECK(l.take() == expected);
+    CHECK(l.view().empty());
+
+    auto raw = std::string("test kvp1=42i");
+    CHECK(line(std::move(raw)).get() == "test kvp1=42i");
+}
+
+
+TEST_CASE("chained lines are joined by newlines") {
+    auto dummy = dummy_timestamp{ "12345" };
+
+    auto chained = line("a", key_value_pairs(), key_value_pairs("v", 1))
+        ("b", key_value_pairs("t", "x"), key_value_pairs("v", 2))
+        ("c", key_value_pairs(), key_value_pairs("v", 3.5), dummy);
+
+    CHECK(chained.get() == "a v=1i\nb,t=\"x\" v=2i\nc v=3.5 12345");
+}
+
+
 TEST_CASE_METHOD(simple_connected_test, "inserting values using the simple api", "[connected]") {
     db.insert(line("test", key_value_pairs("mytag", 424242L), key_value_pairs("value", "hello world!")));
 
@@ -252,7 +286,7 @@ SCENARIO_METHOD(simple_connected_test, "more than 1000 inserts per second") {
 
                 THEN("More than N lines per second can be sent") {
                     // Wait for all submissions to be sent via HTTP using the new API
-                    asyncdb.wait_for_submission(std::chrono::milliseconds(200));
+                    asyncdb.wait_for_submission();
                     
                     auto submit_duration = std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1);
                     double count_per_second = submit_duration.count() > 0 
@@ -374,7 +408,7 @@ SCENARIO_METHOD(simple_connected_test, "sensible batching configuration") {
 
             THEN("Report performance metrics (no assertions)") {
                 // Wait for all submissions to be sent via HTTP using the new API
-                batched_db.wait_for_submission(std::chrono::milliseconds(100));
+                batched_db.wait_for_submission();
                 
                 auto submit_duration = std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1);
                 double submit_rate = submit_duration.count() > 0 
@@ -432,3 +466,657 @@ bool simple_connected_test::db_exists()
 {
     return database_exists(db_name);
 }
+
+TEST_CASE_METHOD(simple_connected_test, "batches are split at line boundaries to stay within max_bytes", "[connected]") {
+    constexpr std::size_t max_bytes = 4096;
+    constexpr unsigned long long count = 2000;
+
+    std::atomic<std::size_t> largest{0};
+    std::atomic<unsigned long long> failures{0};
+    {
+        influxdb::async_api::simple_db asyncdb("http://localhost:8086", db_name,
+            influxdb::api::db_config(influxdb::api::batch_config(1000, 100, max_bytes)));
+
+        auto http_events_sub = asyncdb.http_events().subscribe([&](influxdb::api::http_result const& result) {
+            if (!result.success)
+                failures.fetch_add(1);
+            auto seen = largest.load();
+            while (result.bytes_sent > seen && !largest.compare_exchange_weak(seen, result.bytes_sent)) {}
+        });
+
+        for (unsigned long long i = 0; i < count; ++i) {
+            asyncdb.insert(line("bytes_test", key_value_pairs("my_count", i), key_value_pairs("value", std::string(i % 200, 'x'))));
+        }
+
+        // chained lines far larger than max_bytes are split as well
+        auto chained = line("bytes_test", key_value_pairs("my_count", count), key_value_pairs("value", std::string(100, 'y')));
+        for (unsigned long long i = count + 1; i < 2 * count; ++i) {
+            chained("bytes_test", key_value_pairs("my_count", i), key_value_pairs("value", std::string(100, 'y')));
+        }
+        asyncdb.insert(std::move(chained));
+
+        asyncdb.wait_for_submission();
+        http_events_sub.unsubscribe();
+    }
+
+    CHECK(wait_for_async_inserts(2 * count, "bytes_test"));
+    CHECK(failures.load() == 0);
+    CHECK(largest.load() > 0);
+    CHECK(largest.load() <= max_bytes);
+}
+
+namespace {
+    // lines until the flusher is stuck behind a stalled server: it can hold
+    // one batch on the wire and one waiting for it, the rest has to queue
+    constexpr unsigned overflow_total = 5000;
+
+    influxdb::api::db_config overflow_config(influxdb::api::overflow_policy policy) {
+        influxdb::api::db_config config(influxdb::api::batch_config(100, 10));
+        config.queue = influxdb::api::queue_config(1024, policy);
+        return config;
+    }
+
+    // lines that can be told apart by their number i
+    line numbered_line(unsigned i) {
+        return line("numbered", key_value_pairs("i", i), key_value_pairs("value", "hi!"));
+    }
+
+    bool is_numbered_line(std::string const& l, unsigned i) {
+        auto const tag = "numbered,i=" + std::to_string(i);
+        return l.compare(0, tag.size(), tag) == 0 && l.size() > tag.size() && !std::isdigit(static_cast<unsigned char>(l[tag.size()]));
+    }
+
+    bool contains_numbered_line(std::vector<std::string> const& lines, unsigned i) {
+        return std::any_of(lines.begin(), lines.end(), [i](std::string const& l) { return is_numbered_line(l, i); });
+    }
+}
+
+TEST_CASE("a full queue drops or rejects the newest lines with drop_newest and fail") {
+    using influxdb::api::overflow_policy;
+
+    for (auto policy : { overflow_policy::drop_newest, overflow_policy::fail }) {
+        http_sink sink;
+        sink.hold();
+        influxdb::async_api::simple_db asyncdb(sink.url(), "testdb", overflow_config(policy));
+        CHECK(asyncdb.queue_capacity() == 1024);
+
+        unsigned accepted = 0;
+        for (unsigned i = 0; i < overflow_total; ++i) {
+            if (asyncdb.insert(numbered_line(i)))
+                ++accepted;
+            CHECK(asyncdb.queue_depth() <= asyncdb.queue_capacity());
+        }
+
+        CHECK(asyncdb.dropped() > 0);
+        CHECK(accepted + asyncdb.dropped() == overflow_total);
+
+        sink.release();
+        REQUIRE(asyncdb.flush(std::chrono::milliseconds(10000)));
+        auto const lines = sink.accepted_lines();
+        CHECK(lines.size() == accepted);
+        // the first lines made it, the last ones were turned away
+        CHECK(contains_numbered_line(lines, 0));
+        CHECK(!contains_numbered_line(lines, overflow_total - 1));
+    }
+}
+
+TEST_CASE("a full queue makes room for the newest lines with drop_oldest") {
+    http_sink sink;
+    sink.hold();
+    influxdb::async_api::simple_db asyncdb(sink.url(), "testdb", overflow_config(influxdb::api::overflow_policy::drop_oldest));
+
+    for (unsigned i = 0; i < overflow_total; ++i) {
+        CHECK(asyncdb.insert(numbered_line(i)));
+        CHECK(asyncdb.queue_depth() <= asyncdb.queue_capacity());
+    }
+    CHECK(asyncdb.dropped() > 0);
+
+    sink.release();
+    REQUIRE(asyncdb.flush(std::chrono::milliseconds(10000)));
+    auto const lines = sink.accepted_lines();
+    CHECK(lines.size() + asyncdb.dropped() == overflow_total);
+    // the queue ends with the lines inserted last, in order
+    REQUIRE(lines.size() >= 1024);
+    for (unsigned i = 0; i < 1024; ++i) {
+        CHECK(is_numbered_line(lines[lines.size() - 1024 + i], overflow_total - 1024 + i));
+    }
+}
+
+TEST_CASE("a full queue makes insert wait for room with block") {
+    http_sink sink;
+    sink.hold();
+    influxdb::async_api::simple_db asyncdb(sink.url(), "testdb", overflow_config(influxdb::api::overflow_policy::block));
+
+    std::atomic<unsigned> inserted{ 0 };
+    std::atomic<bool> all_accepted{ true };
+    std::thread producer([&] {
+        for (unsigned i = 0; i < overflow_total; ++i) {
+            if (!asyncdb.insert(numbered_line(i))) {
+                all_accepted = false;
+            }
+            inserted.fetch_add(1);
+        }
+    });
+
+    // the producer is stuck as long as the server does not answer
+    auto const full_by = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (asyncdb.queue_depth() < asyncdb.queue_capacity() && std::chrono::steady_clock::now() < full_by) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    CHECK(asyncdb.queue_depth() == asyncdb.queue_capacity());
+    CHECK(inserted.load() < overflow_total);
+
+    sink.release();
+    producer.join();
+    CHECK(all_accepted.load());
+    CHECK(asyncdb.dropped() == 0);
+
+    REQUIRE(asyncdb.flush(std::chrono::milliseconds(10000)));
+    auto const lines = sink.accepted_lines();
+    CHECK(lines.size() == overflow_total);
+    CHECK(contains_numbered_line(lines, overflow_total - 1));
+}
+
+TEST_CASE("try_insert leaves a line that was not queued with the caller") {
+    influxdb::api::db_config config(influxdb::api::batch_config(1000, 10));
+    config.queue = influxdb::api::queue_config(1024);
+    influxdb::async_api::simple_db asyncdb("http://localhost:424242", "testdb", config);
+
+    for (int i = 0; i < 5000; ++i) {
+        auto l = line("overflow", key_value_pairs("i", i), key_value_pairs("value", "hi!"));
+        if (!asyncdb.try_insert(std::move(l))) {
+            CHECK(!l.view().empty());
+        }
+    }
+    CHECK(asyncdb.dropped() == 0);
+}
+
+TEST_CASE_METHOD(simple_connected_test, "sharded workers keep the lines of each series in order", "[connected]") {
+    constexpr int series = 8;
+    constexpr int per_series = 500;
+    // all lines of a series share a timestamp: the point left is the one written last
+    auto const stamp = dummy_timestamp{ "1000000000" };
+
+    {
+        influxdb::api::db_config config(influxdb::api::batch_config(100, 20));
+        config.queue.workers = 4;
+        influxdb::async_api::simple_db asyncdb("http://localhost:8086", db_name, config);
+
+        for (int i = 0; i < per_series; ++i) {
+            for (int s = 0; s < series; ++s) {
+                asyncdb.insert(line("shard_test", key_value_pairs("series", s), key_value_pairs("value", i), stamp));
+            }
+        }
+
+        asyncdb.wait_for_submission();
+    }
+
+    CHECK(wait_for_async_inserts(series, "shard_test", 1));
+    auto const overtaken = raw_db.get(std::string("select * from ") + db_name + "..shard_test where value < " + std::to_string(per_series - 1));
+    CHECK(overtaken.find("values") == std::string::npos);
+}
+
+TEST_CASE("each worker has a queue of its own") {
+    influxdb::api::db_config config(influxdb::api::batch_config(1000, 10));
+    config.queue = influxdb::api::queue_config(1024, influxdb::api::overflow_policy::fail, 4);
+    influxdb::async_api::simple_db asyncdb("http://localhost:424242", "testdb", config);
+
+    CHECK(asyncdb.queue_capacity() == 4 * 1024);
+
+    // lines of different series, chained into one insert, are queued one by one
+    auto lines = line("shards", key_value_pairs("series", 0), key_value_pairs("value", 0));
+    for (int s = 1; s < 16; ++s) {
+        lines("shards", key_value_pairs("series", s), key_value_pairs("value", s));
+    }
+    CHECK(asyncdb.insert(std::move(lines)));
+    CHECK(asyncdb.queue_depth() <= 16);
+    CHECK(asyncdb.dropped() == 0);
+}
+
+TEST_CASE("flush returns once every queued line is resolved") {
+    // a long time window: without flush() the lines would wait for 10 s
+    influxdb::api::db_config config(influxdb::api::batch_config(1000, 10000));
+    config.queue.workers = 2;
+    influxdb::async_api::simple_db asyncdb("http://localhost:424242", "testdb", config);
+
+    CHECK(asyncdb.flush());
+
+    for (int i = 0; i < 100; ++i) {
+        asyncdb.insert(line("flush_test", key_value_pairs("i", i), key_value_pairs("value", "hi!")));
+    }
+
+    auto const start = std::chrono::steady_clock::now();
+    // nothing listens there: the lines are resolved as failed
+    CHECK(asyncdb.flush(std::chrono::milliseconds(5000)));
+    CHECK(std::chrono::steady_clock::now() - start < std::chrono::seconds(5));
+    CHECK(asyncdb.queue_depth() == 0);
+}
+
+TEST_CASE_METHOD(simple_connected_test, "flushed lines can be queried right away", "[connected]") {
+    constexpr unsigned long long count = 1000;
+
+    influxdb::async_api::simple_db asyncdb("http://localhost:8086", db_name,
+        influxdb::api::db_config(influxdb::api::batch_config(300, 10000)));
+
+    for (unsigned long long i = 0; i < count; ++i) {
+        asyncdb.insert(line("flush_test", key_value_pairs("my_count", i), key_value_pairs("value", "hi!")));
+    }
+    REQUIRE(asyncdb.flush());
+
+    auto const response = raw_db.get(std::string("select count(*) from ") + db_name + "..flush_test");
+    CHECK(extract_count_from_influxdb_response(response) == count);
+}
+
+TEST_CASE("wait_for_submission waits for the lines inserted before it, not for silence") {
+    influxdb::api::db_config config(influxdb::api::batch_config(1000, 50));
+    influxdb::async_api::simple_db asyncdb("http://localhost:424242", "testdb", config);
+
+    auto start = std::chrono::steady_clock::now();
+    asyncdb.wait_for_submission();
+    CHECK(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(50));
+
+    std::atomic<int> events{0};
+    auto http_events_sub = asyncdb.http_events().subscribe([&](influxdb::api::http_result const&) {
+        events.fetch_add(1);
+    });
+
+    for (int i = 0; i < 10; ++i) {
+        asyncdb.insert(line("wait_test", key_value_pairs("i", i), key_value_pairs("value", "hi!")));
+    }
+    // the batch leaves after its 50 ms window and fails: nothing listens there
+    asyncdb.wait_for_submission();
+    CHECK(events.load() == 1);
+    CHECK(asyncdb.queue_depth() == 0);
+
+    http_events_sub.unsubscribe();
+}
+
+TEST_CASE("wait_for_submission gives up after its timeout") {
+    http_sink sink;
+    sink.hold();
+    influxdb::async_api::simple_db asyncdb(sink.url(), "testdb", influxdb::api::db_config(influxdb::api::batch_config(1, 0)));
+
+    asyncdb.insert(line("wait_test", key_value_pairs("i", 0), key_value_pairs("value", "hi!")));
+    REQUIRE(sink.wait_for_requests(1));
+
+    // the server does not answer
+    auto const start = std::chrono::steady_clock::now();
+    CHECK(!asyncdb.wait_for_submission(std::chrono::milliseconds(100)));
+    auto const waited = std::chrono::steady_clock::now() - start;
+    CHECK(waited >= std::chrono::milliseconds(100));
+    CHECK(waited < std::chrono::seconds(5));
+
+    sink.release();
+    CHECK(asyncdb.wait_for_submission(std::chrono::milliseconds(5000)));
+    CHECK(sink.accepted_lines().size() == 1);
+}
+
+// spilling maps its segment files with mmap, which is POSIX only
+#ifndef _WIN32
+TEST_CASE("batches the server does not take are spilled to disk and kept across restarts") {
+    auto const directory = (std::filesystem::temp_directory_path() / "influxdb_cpp_rest_async_spill").string();
+    std::filesystem::remove_all(directory);
+
+    influxdb::api::db_config config(influxdb::api::batch_config(100, 10));
+    config.spill = influxdb::api::spill_config(directory, 16 * 1024 * 1024);
+
+    {
+        influxdb::async_api::simple_db asyncdb("http://localhost:424242", "testdb", config);
+        for (int i = 0; i < 1000; ++i) {
+            asyncdb.insert(line("spill_test", key_value_pairs("i", i), key_value_pairs("value", "hi!")));
+        }
+        // nothing listens there: the batches are spilled instead of dropped
+        REQUIRE(asyncdb.flush());
+
+        auto const stats = asyncdb.spill_stats();
+        CHECK(stats.spilled_batches > 0);
+        CHECK(stats.pending_batches > 0);
+        CHECK(stats.replayed_batches == 0);
+        CHECK(asyncdb.dropped() == 0);
+    }
+
+    {
+        influxdb::async_api::simple_db asyncdb("http://localhost:424242", "testdb", config);
+        CHECK(asyncdb.spill_stats().pending_batches > 0);
+    }
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST_CASE("a spilled batch is not overtaken by the next one") {
+    auto const directory = (std::filesystem::temp_directory_path() / "influxdb_cpp_rest_spill_order").string();
+    std::filesystem::remove_all(directory);
+
+    // the first batch is refused as by an overloaded server, then all are taken
+    http_sink sink([](std::size_t request) { return request == 0 ? 503 : 204; });
+    sink.hold();
+
+    influxdb::api::db_config config(influxdb::api::batch_config(100, 10));
+    config.http.max_in_flight = 2;
+    config.spill = influxdb::api::spill_config(directory);
+    config.spill.retry_ms = 10;
+    influxdb::async_api::simple_db asyncdb(sink.url(), "testdb", config);
+
+    constexpr unsigned count = 300;
+    for (unsigned i = 0; i < 100; ++i) {
+        asyncdb.insert(numbered_line(i));
+    }
+    REQUIRE(sink.wait_for_requests(1));
+
+    // the next batches are complete while the first one waits for its answer
+    for (unsigned i = 100; i < count; ++i) {
+        asyncdb.insert(numbered_line(i));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    sink.release();
+
+    auto const replayed_by = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (sink.accepted_lines().size() < count && std::chrono::steady_clock::now() < replayed_by) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    auto const lines = sink.accepted_lines();
+    REQUIRE(lines.size() == count);
+    for (unsigned i = 0; i < count; ++i) {
+        CHECK(is_numbered_line(lines[i], i));
+    }
+    CHECK(asyncdb.spill_stats().replayed_batches > 0);
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST_CASE("the flusher keeps batching while a spilled batch is replayed") {
+    auto const directory = (std::filesystem::temp_directory_path() / "influxdb_cpp_rest_spill_replay").string();
+    std::filesystem::remove_all(directory);
+
+    http_sink sink([](std::size_t request) { return request == 0 ? 503 : 204; });
+
+    influxdb::api::db_config config(influxdb::api::batch_config(100, 10));
+    config.spill = influxdb::api::spill_config(directory);
+    config.spill.retry_ms = 200;
+    influxdb::async_api::simple_db asyncdb(sink.url(), "testdb", config);
+
+    for (unsigned i = 0; i < 100; ++i) {
+        asyncdb.insert(numbered_line(i));
+    }
+    REQUIRE(asyncdb.flush(std::chrono::milliseconds(5000)));
+    REQUIRE(asyncdb.spill_stats().pending_batches == 1);
+
+    // the replay gets no answer for now
+    sink.hold();
+    REQUIRE(sink.wait_for_requests(2));
+
+    constexpr unsigned count = 1000;
+    for (unsigned i = 100; i < count; ++i) {
+        asyncdb.insert(numbered_line(i));
+    }
+    // the new lines are spilled behind the replayed batch
+    CHECK(asyncdb.flush(std::chrono::milliseconds(2000)));
+    CHECK(asyncdb.metrics().lines_spilled == count);
+
+    sink.release();
+    auto const replayed_by = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (sink.accepted_lines().size() < count && std::chrono::steady_clock::now() < replayed_by) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    auto const lines = sink.accepted_lines();
+    REQUIRE(lines.size() == count);
+    for (unsigned i = 0; i < count; ++i) {
+        CHECK(is_numbered_line(lines[i], i));
+    }
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST_CASE("a spilled batch refused on replay counts as failed") {
+    auto const directory = (std::filesystem::temp_directory_path() / "influxdb_cpp_rest_spill_refused").string();
+    std::filesystem::remove_all(directory);
+
+    // unavailable first, then the batch is refused for its content
+    http_sink sink([](std::size_t request) { return request == 0 ? 503 : 400; });
+
+    influxdb::api::db_config config(influxdb::api::batch_config(100, 10));
+    config.spill = influxdb::api::spill_config(directory);
+    config.spill.retry_ms = 10;
+    influxdb::async_api::simple_db asyncdb(sink.url(), "testdb", config);
+
+    for (unsigned i = 0; i < 100; ++i) {
+        asyncdb.insert(numbered_line(i));
+    }
+    REQUIRE(asyncdb.flush(std::chrono::milliseconds(5000)));
+
+    auto const replayed_by = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (asyncdb.spill_stats().pending_batches > 0 && std::chrono::steady_clock::now() < replayed_by) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    auto const metrics = asyncdb.metrics();
+    CHECK(asyncdb.spill_stats().pending_batches == 0);
+    CHECK(metrics.lines_spilled == 100);
+    CHECK(metrics.lines_failed == 100);
+    CHECK(metrics.lines_dropped == 0);
+
+    std::filesystem::remove_all(directory);
+}
+#endif
+
+TEST_CASE("metrics account for every inserted line") {
+    influxdb::api::db_config config(influxdb::api::batch_config(100, 10000));
+    config.queue.workers = 2;
+    influxdb::async_api::simple_db asyncdb("http://localhost:424242", "testdb", config);
+
+    auto const empty = asyncdb.metrics();
+    CHECK(empty.lines_enqueued == 0);
+    CHECK(empty.batch_lines.count() == 0);
+    CHECK(empty.latency_us.percentile(0.99) == 0);
+
+    for (int i = 0; i < 1000; ++i) {
+        asyncdb.insert(line("metrics_test", key_value_pairs("i", i), key_value_pairs("value", "hi!")));
+    }
+    REQUIRE(asyncdb.flush(std::chrono::milliseconds(5000)));
+
+    // nothing listens there: every batch fails
+    auto const metrics = asyncdb.metrics();
+    CHECK(metrics.lines_enqueued == 1000);
+    CHECK(metrics.lines_sent == 0);
+    CHECK(metrics.lines_failed + metrics.lines_dropped == 1000);
+    CHECK(metrics.queue_depth == 0);
+    CHECK(metrics.queue_capacity == asyncdb.queue_capacity());
+    CHECK(metrics.batch_max_lines == 100);
+    CHECK(metrics.batch_max_time_ms == 10000);
+    CHECK(metrics.batch_lines.count() >= 10);
+    CHECK(metrics.batch_lines.max() <= 100);
+    CHECK(metrics.latency_us.count() == metrics.batch_lines.count());
+}
+
+TEST_CASE("lines that try_insert leaves with the caller are not counted as enqueued") {
+    http_sink sink;
+    sink.hold();
+    influxdb::async_api::simple_db asyncdb(sink.url(), "testdb", overflow_config(influxdb::api::overflow_policy::block));
+
+    std::uint64_t accepted = 0;
+    for (unsigned i = 0; i < overflow_total; ++i) {
+        if (asyncdb.try_insert(numbered_line(i)))
+            ++accepted;
+    }
+    REQUIRE(accepted < overflow_total);
+    CHECK(asyncdb.metrics().lines_enqueued == accepted);
+
+    sink.release();
+    REQUIRE(asyncdb.flush(std::chrono::milliseconds(10000)));
+    auto const metrics = asyncdb.metrics();
+    CHECK(metrics.lines_enqueued == accepted);
+    CHECK(metrics.lines_sent == accepted);
+}
+
+TEST_CASE("http events are plain data with interned error messages") {
+    auto const refused = influxdb::api::intern_http_error("connection refused");
+    CHECK(refused != influxdb::api::http_error_none);
+    CHECK(influxdb::api::intern_http_error("connection refused") == refused);
+    CHECK(influxdb::api::http_error_message(refused) == "connection refused");
+    CHECK(influxdb::api::intern_http_error("") == influxdb::api::http_error_none);
+    CHECK(influxdb::api::http_operation_of("insert") == influxdb::api::http_operation::insert);
+
+    influxdb::api::db_config config(influxdb::api::batch_config(100, 10000));
+    influxdb::async_api::simple_db asyncdb("http://localhost:424242", "testdb", config);
+
+    std::vector<influxdb::api::http_event> events;
+    // nothing listens there: every request fails, so sampling keeps them all
+    asyncdb.on_http_event([&](influxdb::api::http_event const& event) {
+        events.push_back(event);
+    }, 1000);
+
+    for (int i = 0; i < 1000; ++i) {
+        asyncdb.insert(line("event_test", key_value_pairs("i", i), key_value_pairs("value", "hi!")));
+    }
+    REQUIRE(asyncdb.flush(std::chrono::milliseconds(5000)));
+    asyncdb.on_http_event(nullptr);
+
+    CHECK(events.size() == asyncdb.metrics().batch_lines.count());
+    for (auto const& event : events) {
+        CHECK(!event.success);
+        CHECK(event.operation == influxdb::api::http_operation::insert);
+        CHECK(event.status_code == 0);
+        CHECK(event.bytes_sent > 0);
+        CHECK(!influxdb::api::http_error_message(event.error).empty());
+    }
+}
+
+TEST_CASE("adaptive batches stay small while the server is unreachable") {
+    influxdb::api::db_config config(influxdb::api::batch_config(1000, 1000));
+    config.batch.adaptive = influxdb::api::adaptive_batch_config(true, 100);
+    config.batch.adaptive.min_lines = 50;
+    influxdb::async_api::simple_db asyncdb("http://localhost:424242", "testdb", config);
+
+    CHECK(asyncdb.metrics().batch_max_lines == 50);
+    CHECK(asyncdb.metrics().batch_max_time_ms == 50);
+
+    for (int i = 0; i < 1000; ++i) {
+        asyncdb.insert(line("adaptive_test", key_value_pairs("i", i), key_value_pairs("value", "hi!")));
+    }
+    REQUIRE(asyncdb.flush(std::chrono::milliseconds(5000)));
+
+    // every request fails: the batches never grow
+    auto const metrics = asyncdb.metrics();
+    CHECK(metrics.batch_max_lines == 50);
+    CHECK(metrics.batch_lines.max() <= 50);
+    CHECK(metrics.batch_lines.count() >= 20);
+}
+
+TEST_CASE_METHOD(simple_connected_test, "series-sorted batches write the same points", "[connected]") {
+    constexpr int series = 8;
+    constexpr int per_series = 500;
+
+    {
+        influxdb::api::db_config config(influxdb::api::batch_config(1000, 20));
+        config.batch.sort_by_series = true;
+        influxdb::async_api::simple_db asyncdb("http://localhost:8086", db_name, config);
+
+        for (int i = 0; i < per_series; ++i) {
+            for (int s = 0; s < series; ++s) {
+                // the first half of the points is overwritten by the second
+                auto const stamp = dummy_timestamp{ std::to_string(1000000000 + i % (per_series / 2)) };
+                asyncdb.insert(line("sort_test", key_value_pairs("series", s), key_value_pairs("value", i), stamp));
+            }
+        }
+
+        REQUIRE(asyncdb.flush());
+    }
+
+    CHECK(wait_for_async_inserts(series * per_series / 2, "sort_test", 1));
+    auto const overwritten = raw_db.get(std::string("select * from ") + db_name + "..sort_test where value < " + std::to_string(per_series / 2));
+    CHECK(overwritten.find("values") == std::string::npos);
+}
+
+TEST_CASE("coalesced lines are counted while the server is unreachable") {
+    influxdb::api::db_config config(influxdb::api::batch_config(1000, 10000));
+    config.batch.coalesce = true;
+    influxdb::async_api::simple_db asyncdb("http://localhost:424242", "testdb", config);
+
+    for (int i = 0; i < 1000; ++i) {
+        auto const stamp = dummy_timestamp{ std::to_string(1000000000 + i % 10) };
+        asyncdb.insert(line("coalesce_test", key_value_pairs("series", 1), key_value_pairs("value", i), stamp));
+    }
+    REQUIRE(asyncdb.flush(std::chrono::milliseconds(5000)));
+
+    // one batch of ten points; the merged lines fail with it
+    auto const metrics = asyncdb.metrics();
+    CHECK(metrics.batch_lines.count() == 1);
+    CHECK(metrics.batch_lines.max() == 10);
+    CHECK(metrics.lines_coalesced == 990);
+    CHECK(metrics.lines_failed + metrics.lines_dropped == 1000);
+}
+
+TEST_CASE_METHOD(simple_connected_test, "coalesced points keep the fields of all their lines", "[connected]") {
+    constexpr int points = 100;
+
+    {
+        influxdb::api::db_config config(influxdb::api::batch_config(1000, 10000));
+        config.batch.coalesce = true;
+        influxdb::async_api::simple_db asyncdb("http://localhost:8086", db_name, config);
+
+        for (int i = 0; i < points; ++i) {
+            auto const stamp = dummy_timestamp{ std::to_string(1000000000 + i) };
+            asyncdb.insert(line("coalesce_test", key_value_pairs("series", 1), key_value_pairs("a", i), stamp));
+            asyncdb.insert(line("coalesce_test", key_value_pairs("series", 1), key_value_pairs("b", i), stamp));
+            // replaces the first a of the point
+            asyncdb.insert(line("coalesce_test", key_value_pairs("series", 1), key_value_pairs("a", points + i), stamp));
+        }
+
+        REQUIRE(asyncdb.flush());
+        CHECK(asyncdb.metrics().lines_coalesced == 2 * points);
+    }
+
+    auto const count = [this](std::string const& what) {
+        return extract_count_from_influxdb_response(raw_db.get("select count(" + what + ") from " + db_name + "..coalesce_test"));
+    };
+    CHECK(count("a") == points);
+    CHECK(count("b") == points);
+    auto const replaced = raw_db.get(std::string("select * from ") + db_name + "..coalesce_test where a < " + std::to_string(points));
+    CHECK(replaced.find("values") == std::string::npos);
+}
+
+TEST_CASE("aggregated lines are counted while the server is unreachable") {
+    influxdb::api::db_config config(influxdb::api::batch_config(4, 10000));
+    config.aggregate = influxdb::api::aggregate_config(1000, { "aggregate_test" });
+    influxdb::async_api::simple_db asyncdb("http://localhost:424242", "testdb", config);
+
+    for (int i = 0; i < 1000; ++i) {
+        // ten series of 100 points each, all in the same second
+        auto const stamp = dummy_timestamp{ std::to_string(1000000000LL + i) };
+        asyncdb.insert(line("aggregate_test", key_value_pairs("series", i % 10), key_value_pairs("value", i), stamp));
+    }
+    asyncdb.insert(line("other_test", key_value_pairs("series", 1), key_value_pairs("value", 1)));
+    REQUIRE(asyncdb.flush(std::chrono::milliseconds(5000)));
+
+    // flush() sends the open windows: one line per series stands for its
+    // points, and batches are limited by the lines they carry
+    auto const metrics = asyncdb.metrics();
+    CHECK(metrics.lines_aggregated == 1000);
+    CHECK(metrics.lines_failed + metrics.lines_dropped == 1001);
+    CHECK(metrics.batch_lines.max() <= 4);
+    CHECK(metrics.batch_lines.count() >= 3);
+}
+
+TEST_CASE_METHOD(simple_connected_test, "aggregated windows can be queried as statistics", "[connected]") {
+    {
+        influxdb::api::db_config config(influxdb::api::batch_config(1000, 10000));
+        config.aggregate = influxdb::api::aggregate_config(1000);
+        influxdb::async_api::simple_db asyncdb("http://localhost:8086", db_name, config);
+
+        // the values 1..100 in the second from 1 s, 101..200 in the one from 2 s
+        for (int i = 0; i < 200; ++i) {
+            auto const stamp = dummy_timestamp{ std::to_string(1000000000LL * (1 + i / 100) + 1000000LL * (i % 100)) };
+            asyncdb.insert(line("aggregate_test", key_value_pairs("series", 1), key_value_pairs("value", i + 1), stamp));
+        }
+
+        REQUIRE(asyncdb.flush());
+        CHECK(asyncdb.metrics().lines_aggregated == 200);
+    }
+
+    auto const response = raw_db.get(std::string("select value_min, value_max, value_mean, value_count, value_last from ") + db_name + "..aggregate_test");
+    CHECK(response.find("[\"1970-01-01T00:00:01Z\",1,100,50.5,100,100]") != std::string::npos);
+    CHECK(response.find("[\"1970-01-01T00:00:02Z\",101,200,150.5,100,200]") != std::string::npos);
+}
@@ -0,0 +1,166 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+
+#include <catch2/catch_test_macros.hpp>
+#include "../influxdb-cpp-rest/spill_queue.h"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+// the segment files are mapped with mmap, which is POSIX only
+#ifndef _WIN32
+
+using namespace influxdb::utility;
+namespace fs = std::filesystem;
+
+namespace {
+    // a fresh directory, removed again at the end of the test
+    struct spill_directory {
+        fs::path path;
+
+        explicit spill_directory(std::string const& name)
+            : path(fs::temp_directory_path() / ("influxdb_cpp_rest_" + name)) {
+            fs::remove_all(path);
+        }
+
+        ~spill_directory() {
+            std::error_code ignored;
+            fs::remove_all(path, ignored);
+        }
+
+        std::size_t files() const {
+            std::size_t count = 0;
+            for (auto const& entry : fs::directory_iterator(path))
+                count += entry.path().extension() == ".spill";
+            return count;
+        }
+
+        fs::path last_file() const {
+            fs::path last;
+            for (auto const& entry : fs::directory_iterator(path))
+                last = std::max(last, entry.path());
+            return last;
+        }
+    };
+
+    std::string batch(int i) {
+        return "spill,i=" + std::to_string(i) + " value=" + std::to_string(i) + "i\n";
+    }
+}
+
+TEST_CASE("spilled batches come back in order") {
+    spill_directory dir("order");
+    spill_queue queue(dir.path.string(), 4096, 1 << 20);
+
+    CHECK(queue.empty());
+    for (int i = 0; i < 500; ++i) {
+        REQUIRE(queue.append(batch(i), 1));
+    }
+    CHECK(queue.stats().pending_batches == 500);
+    CHECK(queue.stats().segments > 1);
+
+    std::string value;
+    unsigned lines = 0;
+    for (int i = 0; i < 500; ++i) {
+        REQUIRE(queue.front(value, lines));
+        CHECK(value == batch(i));
+        CHECK(lines == 1);
+        queue.pop();
+    }
+    CHECK(queue.empty());
+    CHECK(!queue.front(value, lines));
+
+    // drained: no segment left on disk
+    CHECK(queue.stats().segments == 0);
+    CHECK(dir.files() == 0);
+}
+
+TEST_CASE("spilled batches survive reopening the queue") {
+    spill_directory dir("reopen");
+    {
+        spill_queue queue(dir.path.string(), 4096, 1 << 20);
+        for (int i = 0; i < 200; ++i) {
+            REQUIRE(queue.append(batch(i), 1));
+        }
+        for (int i = 0; i < 50; ++i) {
+            queue.pop();
+        }
+    }
+
+    spill_queue queue(dir.path.string(), 4096, 1 << 20);
+    CHECK(queue.stats().pending_batches == 150);
+
+    std::string value;
+    unsigned lines = 0;
+    REQUIRE(queue.front(value, lines));
+    CHECK(value == batch(50));
+
+    // new batches go behind the recovered ones
+    REQUIRE(queue.append(batch(1000), 1));
+    for (int i = 50; i < 200; ++i) {
+        queue.pop();
+    }
+    REQUIRE(queue.front(value, lines));
+    CHECK(value == batch(1000));
+}
+
+TEST_CASE("a corrupted record ends its segment on recovery") {
+    spill_directory dir("corrupt");
+    {
+        spill_queue queue(dir.path.string(), 1 << 16, 1 << 20);
+        for (int i = 0; i < 10; ++i) {
+            REQUIRE(queue.append(batch(i), 1));
+        }
+    }
+
+    // flip a byte in the payload of the sixth record
+    {
+        std::fstream file(dir.last_file(), std::ios::in | std::ios::out | std::ios::binary);
+        std::string contents(1 << 16, '\0');
+        file.read(&contents[0], static_cast<std::streamsize>(contents.size()));
+        auto const at = contents.find(batch(5));
+        REQUIRE(at != std::string::npos);
+        file.seekp(static_cast<std::streamoff>(at));
+        file.put('X');
+    }
+
+    spill_queue queue(dir.path.string(), 1 << 16, 1 << 20);
+    CHECK(queue.stats().pending_batches == 5);
+
+    // the space after the last good record is reused
+    REQUIRE(queue.append(batch(100), 1));
+    std::string value;
+    unsigned lines = 0;
+    for (int i = 0; i < 5; ++i) {
+        queue.pop();
+    }
+    REQUIRE(queue.front(value, lines));
+    CHECK(value == batch(100));
+}
+
+TEST_CASE("the spill queue stays within its disk budget") {
+    spill_directory dir("budget");
+    spill_queue queue(dir.path.string(), 4096, 3 * 4096);
+
+    int appended = 0;
+    while (queue.append(batch(appended), 1)) {
+        ++appended;
+    }
+    CHECK(appended > 0);
+    CHECK(queue.stats().segments == 3);
+    CHECK(queue.stats().rejected_batches == 1);
+
+    // larger than a segment: never fits
+    CHECK(!queue.append(std::string(8192, 'x'), 1));
+
+    queue.pop();
+    CHECK(queue.stats().pending_batches == static_cast<std::uint64_t>(appended - 1));
+}
+
+#endif
@@ -10,6 +10,10 @@
 
 #include "fixtures.h"
 
+#include <future>
+#include <string>
+#include <vector>
+
 TEST_CASE_METHOD(connected_test, "creating a database", "[connected]") {
     CHECK(database_exists(db_name));
 }
@@ -40,3 +44,40 @@ TEST_CASE("connecting to a nonexistent db results in an exception") {
     influxdb::raw::db_utf8 db("http://localhost:424242", "testdb");
     CHECK_THROWS(db.get("show databases"));
 }
+
+TEST_CASE("asynchronous inserts to a nonexistent db report the failure") {
+    influxdb::api::http_config config;
+    config.max_in_flight = 2;
+    influxdb::raw::db_utf8 db("http://localhost:424242", "testdb", config);
+
+    CHECK_THROWS(db.insert_async("test value=1i").get());
+
+    std::promise<influxdb::api::http_result> reported;
+    db.insert_async("test value=2i", [&](influxdb::api::http_result const& result) {
+        reported.set_value(result);
+    });
+    auto result = reported.get_future().get();
+    CHECK(!result.success);
+    CHECK(result.bytes_sent == std::string("test value=2i").size());
+    CHECK(!result.error_message.empty());
+
+    db.wait_for_in_flight();
+}
+
+TEST_CASE_METHOD(connected_test, "several asynchronous inserts can be in flight", "[connected]") {
+    influxdb::api::http_config config;
+    config.max_in_flight = 4;
+    influxdb::raw::db_utf8 db("http://localhost:8086", db_name, config);
+
+    std::vector<std::future<void>> inserts;
+    for (int i = 0; i < 16; ++i) {
+        inserts.push_back(db.insert_async("in_flight value=" + std::to_string(i) + "i " + std::to_string(i + 1)));
+    }
+    for (auto& insert : inserts) {
+        CHECK_NOTHROW(insert.get());
+    }
+    db.wait_for_in_flight();
+
+    wait_for([] {return false; }, 3);
+    CHECK(extract_count_from_influxdb_response(raw_db.get("select count(*) from " + db_name + "..in_flight")) == 16);
+}